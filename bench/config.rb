@@ -0,0 +1,11 @@
+# headless checks of engine systems that don't need a window or audio device
+# run from this directory with `rbscene bench --frames 2000 --warmup 0`, a failed check raises
+RBScene::Engine.configure do |c|
+  c.start_scene = ParticleCheck
+  c.window_title = 'rbscene checks'
+end
+
+# the checks stop the engine themselves, running out of frames first means one of them never finished
+at_exit do
+  abort "Checks didn't finish, #{Checks.pending.join(', ')} still running" if $!.nil? && !Checks.pending.empty?
+end
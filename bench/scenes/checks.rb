@@ -0,0 +1,21 @@
+# checks register when their scene starts and pass once they've seen what they expect
+module Checks
+  @pending = []
+
+  class << self
+    attr_reader :pending
+
+    def start(name)
+      @pending.push(name)
+    end
+
+    def pass(name)
+      @pending.delete(name)
+      puts "check     #{name} ok"
+    end
+
+    def expect(name, condition, message)
+      raise "#{name} check failed: #{message}" unless condition
+    end
+  end
+end
@@ -0,0 +1,78 @@
+require 'tmpdir'
+
+# music fades run on the audio thread in real time, so this waits on the thread's stats instead of counting steps
+# without an audio device the streams don't play but the thread still runs every command and fade
+class MusicCheck < RBScene::Scene
+  FADE = 0.05
+  TIMEOUT = 2.0
+
+  def setup
+    Checks.start(:music)
+    @tracks = %w[a b].map { |name| RBScene::Assets.load_music(silent_wav("rbscene-check-#{name}.wav")) }
+    @start = RBScene::Debug.audio_stats
+    @sent = 0
+    @phase = :fade_in
+    @tracks[0].play(fade: FADE)
+    @sent += 1
+    @waiting_since = now
+  end
+
+  def update
+    stats = RBScene::Debug.audio_stats
+    fades = stats[:music_fades] - @start[:music_fades]
+    stops = stats[:music_stops] - @start[:music_stops]
+
+    case @phase
+    when :fade_in
+      wait_for(fades >= 1) { crossfade }
+    when :crossfade
+      # the first track fades out and stops while the second fades in
+      wait_for(fades >= 3 && stops >= 1) { fade_out }
+    when :fade_out
+      wait_for(stops >= 2) do
+        commands = stats[:music_commands] - @start[:music_commands]
+        Checks.expect(:music, commands == @sent, "audio thread ran #{commands} of #{@sent} commands")
+        Checks.pass(:music)
+        RBScene::Engine.stop
+      end
+    end
+  end
+
+  private
+
+  def crossfade
+    @tracks[1].play(fade: FADE)
+    @sent += 1
+    @phase = :crossfade
+  end
+
+  def fade_out
+    RBScene::Music.stop(fade: FADE)
+    @sent += 1
+    @phase = :fade_out
+  end
+
+  # headless frames take microseconds, so each one gives the audio thread a moment
+  def wait_for(condition)
+    if condition
+      yield
+      @waiting_since = now
+    else
+      Checks.expect(:music, now - @waiting_since < TIMEOUT, "#{@phase} didn't finish within #{TIMEOUT}s")
+      sleep(0.001)
+    end
+  end
+
+  def now
+    Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  end
+
+  # half a second of 8 bit mono silence, so the check doesn't need an asset
+  def silent_wav(name)
+    path = File.join(Dir.tmpdir, name)
+    samples = "\x80".b * 11_025
+    header = ['RIFF', 36 + samples.bytesize, 'WAVE', 'fmt ', 16, 1, 1, 22_050, 22_050, 1, 8, 'data', samples.bytesize]
+    File.binwrite(path, header.pack('a4Va4a4VvvVVvva4V') + samples)
+    path
+  end
+end
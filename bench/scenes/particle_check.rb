@@ -0,0 +1,52 @@
+require 'tmpdir'
+require 'zlib'
+
+# emitters step once per update, so headless runs give the same counts on any machine
+class ParticleCheck < RBScene::Scene
+  def setup
+    Checks.start(:particles)
+    @steps = 0
+    # 600 a second for half a second, nothing lives past 0.5 seconds
+    @stream = add_emitter(RBScene::Emitter.new(rate: 600, lifetime: 0.25..0.5, velocity_y: -40..40, seed: 1))
+    @burst = add_emitter(RBScene::Emitter.new(lifetime: 0.5, max_particles: 64, seed: 2))
+    # a single Rect is one frame, not an array of its coordinates
+    frame = RBScene::Rect.new(0, 0, 4, 4)
+    @textured = add_emitter(RBScene::Emitter.new(rate: 60, lifetime: 0.5, texture: white_png('rbscene-check-dot.png'),
+                                                 frames: frame, seed: 3))
+    Checks.expect(:particles, @textured.frames == [frame], "single frame became #{@textured.frames.inspect}")
+  end
+
+  def update
+    @steps += 1
+    case @steps
+    when 1
+      @burst.burst(100)
+      Checks.expect(:particles, @burst.count == 64, "burst of 100 should stop at max_particles, got #{@burst.count}")
+    when 30
+      Checks.expect(:particles, @stream.count.between?(150, 300), "expected 150-300 live particles, got #{@stream.count}")
+      Checks.expect(:particles, @burst.count == 64, "burst particles died early, #{@burst.count} left")
+      Checks.expect(:particles, @textured.count.positive?, 'textured emitter spawned nothing')
+      @stream.stop
+      @textured.stop
+    when 62
+      Checks.expect(:particles, @stream.count.zero?, "#{@stream.count} particles outlived their lifetime")
+      Checks.expect(:particles, @burst.count.zero?, "#{@burst.count} burst particles outlived their lifetime")
+      Checks.expect(:particles, @textured.count.zero?, "#{@textured.count} textured particles outlived their lifetime")
+      Checks.pass(:particles)
+      switch(MusicCheck)
+    end
+  end
+
+  private
+
+  # a 4x4 white image, so the check doesn't need an asset
+  def white_png(name)
+    path = File.join(Dir.tmpdir, name)
+    chunk = ->(type, data) { [data.bytesize, type, data, Zlib.crc32(type + data)].pack('Na4a*N') }
+    rows = ("\0".b + ("\xff".b * 16)) * 4
+    png = "\x89PNG\r\n\x1a\n".b + chunk.call('IHDR', [4, 4, 8, 6, 0, 0, 0].pack('NNCCCCC')) +
+          chunk.call('IDAT', Zlib::Deflate.deflate(rows)) + chunk.call('IEND', '')
+    File.binwrite(path, png)
+    path
+  end
+end
@@ -3,5 +3,10 @@ require 'mkmf'
 dir_config('raylib', '/opt/homebrew/include/', '/opt/homebrew/lib/')
 abort('raylib library not found') unless have_library('raylib')
 abort('raylib header not found') unless have_header('raylib.h')
+abort('rlgl header not found') unless have_header('rlgl.h')
+abort('pthread library not found') unless have_library('pthread')
+
+# the particle integration loop is written to be auto-vectorized
+$CFLAGS << ' -O3'
 
 create_makefile('rbscene/rbscene')
@@ -1,12 +1,33 @@
 #include "ruby.h"
 #include "raylib.h"
+#include "rlgl.h"
+#include <math.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "ruby/debug.h"
+#include "ruby/thread.h"
+#include "ruby/util.h"
 
 // global refs to modules and classes, usually for type checks
 static VALUE rbscene_module = Qnil;
+static VALUE assets_class = Qnil;
 static VALUE engine_class = Qnil;
 static VALUE game_object_class = Qnil;
 static VALUE render_props_class = Qnil;
+static VALUE draw_list_class = Qnil;
+static VALUE collision_world_class = Qnil;
+static VALUE ticker_manager_class = Qnil;
+static VALUE atlas_packer_class = Qnil;
 static VALUE rect_class = Qnil;
+static VALUE vector2_class = Qnil;
 static VALUE camera_class = Qnil;
 static VALUE scene_class = Qnil;
 static VALUE texture_class = Qnil;
@@ -14,696 +35,6765 @@ static VALUE sound_class = Qnil;
 static VALUE music_class = Qnil;
 static VALUE input_class = Qnil;
 static VALUE debug_class = Qnil;
+static VALUE emitter_class = Qnil;
+static VALUE tilemap_class = Qnil;
 
 static int window_width = 0;
 static int window_height = 0;
 
+// totals over every atlas built so far
+static int atlas_stats_pages = 0;
+static long long atlas_stats_used_area = 0;
+static long long atlas_stats_total_area = 0;
+
+// how far the frame is between the previous and current simulation step, 1 draws current positions
+static float draw_alpha = 1.0f;
+
+// seconds of game time per simulation step, set from the config when the engine starts running
+static float step_dt = 1.0f / 60;
+
+// objects drawn and skipped by culling during the last frame
+static int draw_stats_drawn = 0;
+static int draw_stats_culled = 0;
+static int draw_stats_particles = 0; // live particles in the scene's emitters
+static int draw_stats_chunks = 0;        // tilemap chunks drawn
+static int draw_stats_chunk_renders = 0; // tilemap chunks rendered into their cache texture
+static int draw_stats_texture_switches = 0; // times consecutive sprites used different textures
+static int draw_stats_static = 0;       // visible static sprites drawn from their layer's cache
+static int draw_stats_static_bakes = 0; // static layers rendered into their cache
+
+typedef struct RBLoadJob RBLoadJob;
+
+// cache bookkeeping shared by textures, sounds and music
+typedef struct
+{
+    size_t bytes;     // memory the asset holds, estimated from its size and format
+    int refs;         // scenes that loaded it, plus one if it was loaded outside any scene
+    bool pinned;      // loaded outside a scene, eg. by a class level texture, never evicted
+    bool cached;      // still in its Assets cache, evicted assets are freed once nothing references them
+    double last_used; // when it was last loaded or released, the least recently used go first
+} RBAssetInfo;
+
 typedef struct
 {
+    RBAssetInfo info;
     Texture2D texture;
+    Rectangle region; // area of texture this handle draws from, the whole texture unless it's an atlas region
+    bool owned;       // atlas regions share their page's texture and must not unload it
+    VALUE page;       // atlas page a region belongs to, nil otherwise
+    RBLoadJob *job;   // set while the texture is still being loaded in the background
 } RBTexture;
 
 typedef struct
 {
+    RBAssetInfo info;
     Music music;
+    unsigned int id; // tells the music thread which stream a command is about
 } RBMusic;
 
+#define SOUND_MAX_VOICES 16    // most copies of one sound that can play at once
+#define SOUND_DEFAULT_VOICES 4 // polyphony of a newly loaded sound
+#define AUDIO_VOICE_LIMIT 256  // upper bound for the global cap on playing voices
+
 typedef struct
 {
-    Sound sound;
+    RBAssetInfo info;
+    Sound sound;                           // voice 0
+    Sound aliases[SOUND_MAX_VOICES - 1];   // the other voices, sharing sound's samples, made the first time they're needed
+    double voice_started[SOUND_MAX_VOICES]; // when each voice last started, 0 while it's idle
+    int alias_count;
+    int max_voices;
+    int priority; // voices of higher priority sounds are stolen last
+    RBLoadJob *job; // set while the sound is still being loaded in the background
 } RBSound;
 
-// used to keep track of game object properties used for rendering
-// faster than just calling rb_iv_get on each of them individually
+// range of spatial grid cells a render slot is currently filed under
+typedef struct
+{
+    int x0, y0, x1, y1;
+    bool inserted;
+    bool oversize; // too big for the grid, kept in a separate list that is always tested
+} RBCellRange;
+
+typedef struct RBDrawList RBDrawList;
+typedef struct RBCollisionWorld RBCollisionWorld;
+
+// game object properties used for rendering live in a structure-of-arrays pool owned by C
+// the draw pass walks these arrays directly instead of going through Ruby objects
+typedef struct
+{
+    int capacity;
+    int count; // number of slots ever handed out, freed slots are reused through the free list
+    int free_head;
+    int *next_free;
+
+    float *x, *y;
+    float *prev_x, *prev_y; // position at the start of the last simulation step, drawing interpolates from here
+    float *width, *height;
+    float *angle;
+    Rectangle *frame;
+    bool *hflip, *vflip;
+    float *origin_x, *origin_y;
+    RBTexture **texture;
+    int *layer; // draw lists are sorted by layer, then z, then add order
+    float *z;
+    bool *is_static; // baked into its list's static cache for the layer instead of drawn every frame
+
+    // culling data, bounds are world space and only recomputed when a slot is marked dirty
+    Rectangle *bounds;
+    bool *dirty;
+    unsigned int *seq; // order added to the owning list, breaks ties in the draw order
+    unsigned int *visit; // last query stamp, avoids returning a slot twice from overlapping cells
+    RBCellRange *cells;
+    RBDrawList **owner;
+    int *list_index; // position in the owner's slots array
+
+    int *body; // index into the owning scene's collision world, -1 if the slot has no hitbox
+    RBCollisionWorld **body_world; // the world body indexes into, NULL if the slot has no hitbox
+} RBRenderPool;
+
+// RenderProps objects are just stable handles into the render pool
 typedef struct
 {
-    float x, y;
-    float width, height;
-    float angle;
-    Rectangle frame;
-    bool hflip, vflip;
-    float origin_x, origin_y;
+    int slot;
+    VALUE texture; // keeps the texture alive while its slot points at it
 } RBRenderProps;
 
+typedef struct
+{
+    int *slots;
+    int count;
+    int capacity;
+} RBGridCell;
+
+// sparse uniform grid of render slots, cells are found through an open addressing hash of their coordinates
+typedef struct
+{
+    float cell_size;
+    int table_capacity; // always a power of two
+    int table_count;
+    long long *keys;
+    int *cell_index; // -1 marks an empty table entry
+    RBGridCell *cells;
+    RBGridCell oversize;
+} RBSpatialGrid;
+
+#define STATIC_CHUNK_SIZE 2048
+
+typedef struct
+{
+    RenderTexture2D target;
+    bool loaded; // only chunks some static sprite overlaps get a render texture
+} RBStaticChunk;
+
+// static sprites of one layer composited into render textures, one per chunk of their combined bounds
+// drawn in place of the sprites underneath the layer's other sprites, and only rebaked when a member changes
+// so a static sprite with a higher z than a dynamic one on its layer still ends up below it
+typedef struct
+{
+    int layer;
+    bool dirty;
+    float x, y; // world position of the first chunk's top left corner
+    int chunk_cols, chunk_rows;
+    RBStaticChunk *chunks; // row major, NULL when the layer has no static sprites
+} RBStaticCache;
+
+// slots of a scene's render pool entries, in draw order
+struct RBDrawList
+{
+    int *slots;
+    int count; // includes holes
+    int capacity;
+    int holes; // removed entries left as -1 so removal is O(1), compacted in order before the next draw
+    unsigned int next_seq;
+    int unsorted; // adds and sort key changes since the list was last sorted
+    bool y_sort;  // entries on the same layer and z are ordered by the bottom edge of their sprite
+
+    RBStaticCache *statics; // sorted by layer
+    int static_count;
+    int *static_layers; // layers whose sprites are all static
+    int static_layer_count;
+    bool static_z_warned; // a static sprite was seen above a dynamic one on its layer, see draw_objects
+    int *batch_layers; // layers whose sprites of equal z are grouped by texture instead of kept in add order
+    int batch_layer_count;
+    unsigned int texture_changes; // texture_id_changes when the list was last sorted
+    RBSpatialGrid *grid; // NULL when the list is not culled against the camera, like UI lists
+};
+
+// bumped whenever a loaded texture gets a new GPU id, lists with batch layers resort when it moves
+static unsigned int texture_id_changes = 0;
+
+typedef struct
+{
+    int x, y, width;
+} RBSkylineNode;
+
+// one atlas page, the skyline is the outline of the top edges of everything packed so far
+typedef struct
+{
+    int size;
+    RBSkylineNode *nodes;
+    int node_count;
+    int node_capacity;
+    long long used_area;
+    int used_width, used_height; // extent of everything packed, padding included
+} RBSkylinePage;
+
+typedef struct
+{
+    int page_size;
+    int padding;
+    RBSkylinePage *pages;
+    int page_count;
+    int page_capacity;
+} RBAtlasPacker;
+
+typedef struct
+{
+    VALUE a, b;
+    int slot_a, slot_b;
+} RBCollisionPair;
+
+// hitboxes of a scene's game objects, bodies are packed and swap removed, render_pool.body maps slots back to them
+struct RBCollisionWorld
+{
+    VALUE *objects;
+    int *slots;
+    Rectangle *hitboxes; // relative to the top left corner of the sprite
+    Rectangle *aabbs;    // world space, refreshed every step
+    bool *callbacks;     // whether the object defines on_collide
+    int *order_pos;
+    int count;
+    int capacity;
+
+    // body indices sorted by left edge, holes from removed bodies are -1
+    int *order;
+    int order_count;
+    int order_capacity;
+
+    RBCollisionPair *pairs;
+    int pair_count;
+    int pair_capacity;
+};
+
+// min and max of a value picked uniformly for each new particle
+typedef struct
+{
+    float min, max;
+} RBRange;
+
+// particles are stored as structure of arrays with the live ones packed at the front
+// the integrate loop only touches plain float arrays so the compiler can vectorize it
+typedef struct
+{
+    int count;
+    int capacity;
+    float *x, *y;
+    float *vx, *vy;
+    float *life;         // seconds left
+    float *inv_lifetime; // 1 / starting life, turns life into progress without a divide per particle
+    float *size;
+    unsigned short *frame;
+
+    // spawn settings, everything is configured from Ruby
+    float spawn_x, spawn_y;          // top left of the area new particles appear in, world space
+    float spawn_width, spawn_height;
+    float rate;       // particles per second while emitting
+    float spawn_debt; // fraction of a particle carried over between steps
+    bool emitting;
+    RBRange lifetime, velocity_x, velocity_y, size_range;
+    Vector2 gravity;
+    Color start_color, end_color; // blended over each particle's life
+
+    VALUE texture; // nil draws plain squares
+    Rectangle *frames;
+    int frame_count;
+    uint32_t rng;
+} RBEmitter;
+
+#define TILEMAP_CHUNK_TILES 16
+
+// tiles drawn once into a texture and redrawn from it every frame until one of them changes
+typedef struct
+{
+    RenderTexture2D target;
+    bool loaded;
+    bool dirty;
+} RBTileChunk;
+
+// tile ids index the tileset the same way Texture#split slices it, left to right then top to bottom, -1 is empty
+typedef struct
+{
+    int cols, rows;
+    int tile_width, tile_height;
+    float x, y; // world position of the top left corner
+    int *tiles; // row major, cols * rows
+    VALUE tileset;
+    int tileset_cols;
+    int tile_count; // tiles in the tileset, ids past this aren't drawn
+
+    bool *solid; // indexed by tile id
+    int solid_count;
+
+    RBTileChunk *chunks; // row major, chunk_cols * chunk_rows
+    int chunk_cols, chunk_rows;
+} RBTilemap;
+
 typedef struct
 {
     int window_width;
     int window_height;
     const char *window_title;
+    double asset_upload_budget; // seconds per frame spent uploading assets loaded in the background
+    bool headless;
+    bool record_frame_times;
+    long max_frames; // engine_run returns after this many frames, 0 runs until the window closes
+    double fixed_dt; // seconds of game time per update step
+    int max_substeps; // most steps run in one frame, a longer stall slows the game down instead
+    int target_fps;
+    bool interpolate;
+    int gc_mode;
+    bool gc_on_scene_switch;
+    int gc_max_skipped_frames;
+    size_t asset_budget; // bytes of cached assets before unused ones are evicted
 } RBEngineConfig;
 
-static void texture_free(void *ptr)
+#define GC_MODE_RUBY 0  // Ruby collects whenever it decides to
+#define GC_MODE_FRAME 1 // GC is off while the frame runs, the engine collects in whatever time the frame has left
+
+static double now_seconds(void)
 {
-    RBTexture *tex = (RBTexture *)ptr;
-    UnloadTexture(tex->texture);
-    ruby_xfree(ptr);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
-static const rb_data_type_t texture_type =
-    {
-        "RBScene::Texture",
-        {0, texture_free, 0},
-        0,
-        0,
-        RUBY_TYPED_FREE_IMMEDIATELY};
+// set by engine_init when running without a window or audio device, eg. for benchmarks on build machines
+static bool headless = false;
 
-static void music_free(void *ptr)
+// frame loop state, stop_requested is set by Engine.stop
+static bool stop_requested = false;
+static long frame_count = 0;
+static long step_count = 0;
+static bool engine_stepping = false; // scenes queue creates and destroys while this is set
+
+typedef struct
 {
-    RBMusic *music = (RBMusic *)ptr;
-    UnloadMusicStream(music->music);
-    ruby_xfree(ptr);
-}
+    double seconds;
+    size_t gc_count;
+} RBFrameLogEntry;
 
-static const rb_data_type_t music_type =
-    {
-        "RBScene::Music",
-        {0, music_free, 0},
-        0,
-        0,
-        RUBY_TYPED_FREE_IMMEDIATELY};
+static RBFrameLogEntry *frame_log = NULL;
+static long frame_log_count = 0;
+static long frame_log_capacity = 0;
 
-static void sound_free(void *ptr)
+// draw calls issued during the last frame, counted even when headless skips them
+static int frame_draw_calls = 0;
+
+// asset pack written by `rbscene pack`, an index followed by pixel and sample data ready to hand to the GPU or audio device
+// the file is mapped once and kept for the life of the process, assets are created straight from the mapped pages
+
+#define PACK_MAGIC "RBSPACK1"
+#define PACK_VERSION 1
+#define PACK_ALIGN 64 // blobs start on a cache line, uploads read them in place
+
+#define PACK_IMAGE 0   // decoded pixels, params are width, height, mipmaps and pixel format
+#define PACK_WAVE 1    // decoded samples, params are frame count, sample rate, sample size and channels
+#define PACK_ENCODED 2 // the original file's bytes, long audio stays encoded so music can stream it
+
+typedef struct
 {
-    RBSound *sound = (RBSound *)ptr;
-    UnloadSound(sound->sound);
-    ruby_xfree(ptr);
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t names_offset; // names are stored NUL terminated so the index can point into the mapping
+    uint64_t names_size;
+} RBPackHeader;
+
+typedef struct
+{
+    uint32_t kind;
+    uint32_t name_offset; // from the start of the names block
+    uint32_t name_length;
+    uint32_t params[4];
+    uint32_t reserved;
+    uint64_t data_offset; // from the start of the file
+    uint64_t data_size;
+} RBPackEntry;
+
+typedef struct
+{
+    char *path;
+    const uint8_t *data;
+    size_t size;
+    const RBPackEntry *entries;
+    uint32_t entry_count;
+    st_table *index; // name -> entry index, keys point into the mapping
+} RBPack;
+
+static RBPack asset_pack = {0};
+
+// main thread only, loader threads get the entry through their job
+static const RBPackEntry *pack_find(const char *path)
+{
+    if (!asset_pack.index)
+        return NULL;
+    if (path[0] == '.' && path[1] == '/')
+        path += 2;
+
+    st_data_t index;
+    if (!st_lookup(asset_pack.index, (st_data_t)path, &index))
+        return NULL;
+    return &asset_pack.entries[index];
 }
 
-static const rb_data_type_t sound_type =
-    {
-        "RBScene::Sound",
-        {0, sound_free, 0},
-        0,
-        0,
-        RUBY_TYPED_FREE_IMMEDIATELY};
+static const void *pack_data(const RBPackEntry *entry)
+{
+    return asset_pack.data + entry->data_offset;
+}
 
-static const rb_data_type_t render_props_type =
-    {
-        "RBScene::RenderObject",
-        {0, RUBY_DEFAULT_FREE, 0},
-        0,
-        0,
-        RUBY_TYPED_FREE_IMMEDIATELY};
+// the image's pixels belong to the mapping, it must never be passed to UnloadImage
+static Image pack_image(const RBPackEntry *entry)
+{
+    return (Image){.data = (void *)pack_data(entry), .width = entry->params[0], .height = entry->params[1],
+                   .mipmaps = entry->params[2], .format = entry->params[3]};
+}
 
-static const rb_data_type_t rect_type =
-    {
-        "RBScene::Rect",
-        {0, RUBY_DEFAULT_FREE, 0},
-        0,
-        0,
-        RUBY_TYPED_FREE_IMMEDIATELY};
+// same as pack_image, the samples belong to the mapping
+static Wave pack_wave(const RBPackEntry *entry)
+{
+    return (Wave){.frameCount = entry->params[0], .sampleRate = entry->params[1],
+                  .sampleSize = entry->params[2], .channels = entry->params[3], .data = (void *)pack_data(entry)};
+}
 
-static const rb_data_type_t camera_type =
-    {
-        "RBScene::Camera",
-        {0, RUBY_DEFAULT_FREE, 0},
-        0,
-        0,
-        RUBY_TYPED_FREE_IMMEDIATELY};
+// raylib picks a decoder from the extension of the original file name
+static const char *pack_file_type(const RBPackEntry *entry)
+{
+    const char *name = (const char *)asset_pack.data + ((const RBPackHeader *)asset_pack.data)->names_offset + entry->name_offset;
+    const char *ext = strrchr(name, '.');
+    return ext ? ext : "";
+}
 
-// global engine variables
-static Camera2D *cam = NULL;
-static RBMusic *current_music = NULL;
+// decodes an encoded entry, safe to call from a loader thread
+static Wave pack_decode_wave(const RBPackEntry *entry)
+{
+    return LoadWaveFromMemory(pack_file_type(entry), pack_data(entry), (int)entry->data_size);
+}
 
-static int symbol_to_keycode(VALUE sym)
+// loads done on the main thread, for comparing loose files against a pack
+static long asset_stats_loads = 0;
+static long asset_stats_packed = 0;
+static double asset_stats_seconds = 0;
+
+static void asset_stats_record(double start, const char *path)
 {
-    Check_Type(sym, T_SYMBOL);
-    const char *name = rb_id2name(SYM2ID(sym));
+    asset_stats_loads++;
+    if (pack_find(path))
+        asset_stats_packed++;
+    asset_stats_seconds += now_seconds() - start;
+}
 
-    if (strcmp(name, "space") == 0)
-        return KEY_SPACE;
-    if (strcmp(name, "enter") == 0)
-        return KEY_ENTER;
-    if (strcmp(name, "escape") == 0)
-        return KEY_ESCAPE;
-    if (strcmp(name, "left") == 0)
-        return KEY_LEFT;
-    if (strcmp(name, "right") == 0)
-        return KEY_RIGHT;
-    if (strcmp(name, "up") == 0)
-        return KEY_UP;
-    if (strcmp(name, "down") == 0)
-        return KEY_DOWN;
-
-    // a-z keys
-    if (strlen(name) == 1 && name[0] >= 'a' && name[0] <= 'z')
-    {
-        return KEY_A + (name[0] - 'a');
-    }
+// loads past the budget evict assets no scene is using, least recently used first
+static size_t asset_budget = SIZE_MAX;
+static size_t asset_cached_bytes = 0;   // assets still in a cache
+static size_t asset_resident_bytes = 0; // assets still in memory, evicted ones count until GC frees them
+static long asset_stats_hits = 0;
+static long asset_stats_evicted = 0;
 
-    rb_raise(rb_eArgError, "Unrecognized key symbol: :%s", name);
-    return -1; // unreachable, but needed for compilation
+// records the memory behind an asset once it's known, and zero once it's freed
+// Ruby is told too, GPU and audio memory don't show up in its malloc accounting otherwise
+static void asset_set_bytes(RBAssetInfo *info, size_t bytes)
+{
+    ssize_t delta = (ssize_t)bytes - (ssize_t)info->bytes;
+    if (info->cached)
+        asset_cached_bytes += delta;
+    asset_resident_bytes += delta;
+    info->bytes = bytes;
+    rb_gc_adjust_memory_usage(delta);
 }
 
-static int inputs_inner_foreach_callback(VALUE key, VALUE value, VALUE arg)
+static size_t texture_bytes(Texture2D texture)
 {
-    // inner entry = {right: [true, false, false], gp_right: [false, false, false]}
-    Check_Type(key, T_SYMBOL);
+    return (size_t)GetPixelDataSize(texture.width, texture.height, texture.format);
+}
 
-    // asserts for internal values are fine, change to rb_raise if this ever becomes user facing code
-    assert(value == Qtrue || value == Qfalse);
+static size_t sound_bytes(Sound sound)
+{
+    return (size_t)sound.frameCount * sound.stream.channels * (sound.stream.sampleSize / 8);
+}
 
-    // create a new array to store the key state results in
-    VALUE keystate_array = rb_ary_new();
-    int code = symbol_to_keycode(key);
+// when headless, textures keep their size but have no GPU data and an id of zero
+static Texture2D texture_from_image(Image image)
+{
+    if (headless)
+        return (Texture2D){.id = 0, .width = image.width, .height = image.height, .mipmaps = 1, .format = image.format};
+    return LoadTextureFromImage(image);
+}
 
-    // [key_down, key_pressed, key_released]
-    VALUE result = IsKeyDown(code) ? Qtrue : Qfalse;
-    rb_ary_push(keystate_array, result);
-    result = IsKeyPressed(code) ? Qtrue : Qfalse;
-    rb_ary_push(keystate_array, result);
-    result = IsKeyReleased(code) ? Qtrue : Qfalse;
-    rb_ary_push(keystate_array, result);
+static Texture2D texture_from_file(const char *path)
+{
+    const RBPackEntry *entry = pack_find(path);
+    if (entry && entry->kind == PACK_IMAGE)
+        return texture_from_image(pack_image(entry));
+    if (!headless)
+        return LoadTexture(path);
+
+    Image image = LoadImage(path);
+    Texture2D texture = texture_from_image(image);
+    UnloadImage(image);
+    return texture;
+}
 
-    rb_hash_aset(arg, key, keystate_array);
-    return ST_CONTINUE;
+// audio is silent when headless, sounds and music are left empty and every playback call skips them
+static Sound sound_from_wave(Wave wave)
+{
+    if (headless)
+        return (Sound){0};
+    return LoadSoundFromWave(wave);
 }
 
-static int inputs_foreach_callback(VALUE key, VALUE value, VALUE arg)
+static Sound sound_from_file(const char *path)
 {
-    // entry looks like this: "right": {right: true, gp_right: false}
-    // key is a string, key inside the hash is a symbol, value is a bool
-    if (TYPE(key) != T_STRING && TYPE(key) != T_SYMBOL)
+    if (headless)
+        return (Sound){0};
+
+    const RBPackEntry *entry = pack_find(path);
+    if (entry && entry->kind == PACK_WAVE)
+        return LoadSoundFromWave(pack_wave(entry));
+    if (entry && entry->kind == PACK_ENCODED)
     {
-        rb_raise(rb_eTypeError, "Expected String or Symbol");
+        Wave wave = pack_decode_wave(entry);
+        Sound sound = LoadSoundFromWave(wave);
+        UnloadWave(wave);
+        return sound;
     }
+    return LoadSound(path);
+}
 
-    Check_Type(value, T_HASH);
-
-    rb_hash_foreach(value, inputs_inner_foreach_callback, value);
+// music streams from the mapping when the pack kept the file encoded, decoded audio can't be streamed so it uses the loose file
+static Music music_from_file(const char *path)
+{
+    if (headless)
+        return (Music){0};
 
-    return ST_CONTINUE;
+    const RBPackEntry *entry = pack_find(path);
+    if (entry && entry->kind == PACK_ENCODED)
+        return LoadMusicStreamFromMemory(pack_file_type(entry), pack_data(entry), (int)entry->data_size);
+    return LoadMusicStream(path);
 }
 
-static RBEngineConfig get_engine_config()
+// an image the caller owns, packed pixels are copied rather than decoded
+static Image image_from_file(const char *path)
 {
-    VALUE config_val = rb_iv_get(engine_class, "@config");
-
-    VALUE window_title_val = rb_iv_get(config_val, "@window_title");
-    Check_Type(window_title_val, T_STRING);
+    const RBPackEntry *entry = pack_find(path);
+    if (entry && entry->kind == PACK_IMAGE)
+        return ImageCopy(pack_image(entry));
+    return LoadImage(path);
+}
 
-    VALUE window_size_val = rb_iv_get(config_val, "@window_size");
-    Check_Type(window_size_val, T_ARRAY);
+static void draw_texture(Texture2D texture, Rectangle src, Rectangle dst, Vector2 origin, float angle, Color tint)
+{
+    frame_draw_calls++;
+    if (!headless)
+        DrawTexturePro(texture, src, dst, origin, angle, tint);
+}
 
-    VALUE window_width_val = rb_ary_entry(window_size_val, 0);
-    VALUE window_height_val = rb_ary_entry(window_size_val, 1);
+// frame profiler, times each phase of engine_run into a ring buffer of recent frames
+// every hook is a single branch on profile_enabled when it's off
 
-    if (!rb_obj_is_kind_of(window_width_val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "Window width is not a Numeric");
+enum
+{
+    PROFILE_ASSETS,
+    PROFILE_INPUT,
+    PROFILE_AUDIO,
+    PROFILE_TICKERS,
+    PROFILE_UPDATE_WORLD,
+    PROFILE_UPDATE_UI,
+    PROFILE_PARTICLES,
+    PROFILE_COLLISION,
+    PROFILE_SCENE_UPDATE,
+    PROFILE_DRAW_WORLD,
+    PROFILE_DEBUG_DRAW,
+    PROFILE_DRAW_UI,
+    PROFILE_GC,
+    PROFILE_PRESENT,
+    PROFILE_PHASE_COUNT
+};
+
+static const char *profile_phase_names[PROFILE_PHASE_COUNT] = {
+    "assets", "input", "audio", "tickers", "update_world", "update_ui", "particles", "collision",
+    "scene_update", "draw_world", "debug_draw", "draw_ui", "gc", "present"};
+
+static const Color profile_phase_colors[PROFILE_PHASE_COUNT] = {
+    PURPLE, ORANGE, BEIGE, GOLD, BLUE, SKYBLUE, PINK, RED, GREEN, DARKGREEN, MAGENTA, LIME, BROWN, GRAY};
 
-    if (!rb_obj_is_kind_of(window_height_val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "Window height is not a Numeric");
+typedef struct
+{
+    long frame;
+    double start;
+    double phases[PROFILE_PHASE_COUNT];
+    double gc_ms;   // time Ruby spent collecting during the frame, wherever it happened
+    long allocated; // Ruby objects allocated during the frame
+} RBProfileFrame;
+
+// per class update cost, frame_* is the latest frame and total_* everything since profiling started
+typedef struct
+{
+    VALUE klass;
+    double frame_seconds;
+    long frame_calls;
+    double total_seconds;
+    long total_calls;
+} RBProfileClass;
+
+static bool profile_enabled = false;
+static bool profile_classes_enabled = false;
+static bool profile_overlay = false;
+
+static RBProfileFrame *profile_frames = NULL;
+static int profile_capacity = 120;
+static int profile_head = 0; // next frame to write
+static int profile_count = 0;
+static double profile_epoch = 0; // trace timestamps are relative to this
+static double profile_lap_start = 0;
+static RBProfileFrame *profile_current = NULL;
+
+static st_table *profile_class_index = NULL;
+static RBProfileClass *profile_class_stats = NULL;
+static int profile_class_count = 0;
+static int profile_class_capacity = 0;
+
+static void profile_reset(void)
+{
+    if (!profile_class_index)
+        profile_class_index = st_init_numtable();
 
-    RBEngineConfig config;
-    config.window_title = StringValueCStr(window_title_val);
-    config.window_width = NUM2UINT(window_width_val);
-    config.window_height = NUM2UINT(window_height_val);
+    REALLOC_N(profile_frames, RBProfileFrame, profile_capacity);
+    profile_head = 0;
+    profile_count = 0;
+    profile_epoch = now_seconds();
+    profile_current = NULL;
 
-    return config;
+    for (int i = 0; i < profile_class_count; i++)
+    {
+        RBProfileClass *stats = &profile_class_stats[i];
+        stats->frame_seconds = stats->total_seconds = 0;
+        stats->frame_calls = stats->total_calls = 0;
+    }
 }
 
-static VALUE engine_init(VALUE self)
+static void profile_begin_frame(long frame)
 {
-    RBEngineConfig config = get_engine_config();
+    profile_current = &profile_frames[profile_head];
+    profile_head = (profile_head + 1) % profile_capacity;
+    if (profile_count < profile_capacity)
+        profile_count++;
 
-    window_width = config.window_width;
-    window_height = config.window_height;
+    memset(profile_current, 0, sizeof(RBProfileFrame));
+    profile_current->frame = frame;
+    profile_current->start = profile_lap_start = now_seconds();
 
-    InitWindow(config.window_width, config.window_height, config.window_title);
-    InitAudioDevice();
-    SetTargetFPS(60);
+    for (int i = 0; i < profile_class_count; i++)
+    {
+        profile_class_stats[i].frame_seconds = 0;
+        profile_class_stats[i].frame_calls = 0;
+    }
+}
 
-    return Qnil;
+// closes the running phase, the next one starts now
+static void profile_lap(int phase)
+{
+    if (!profile_current)
+        return;
+
+    double now = now_seconds();
+    profile_current->phases[phase] += now - profile_lap_start;
+    profile_lap_start = now;
 }
 
-static VALUE engine_update(VALUE self)
+#define PROFILE_LAP(phase)       \
+    do                           \
+    {                            \
+        if (profile_enabled)     \
+            profile_lap(phase);  \
+    } while (0)
+
+static RBProfileClass *profile_class(VALUE klass)
 {
-    RBEngineConfig config = get_engine_config();
+    st_data_t index;
+    if (st_lookup(profile_class_index, (st_data_t)klass, &index))
+        return &profile_class_stats[index];
 
-    window_width = config.window_width;
-    window_height = config.window_height;
+    if (profile_class_count == profile_class_capacity)
+    {
+        profile_class_capacity = profile_class_capacity ? profile_class_capacity * 2 : 32;
+        REALLOC_N(profile_class_stats, RBProfileClass, profile_class_capacity);
+    }
 
-    SetWindowTitle(config.window_title);
-    SetWindowSize(config.window_width, config.window_height);
+    // classes are referenced from C from now on, game object classes live for the whole run anyway
+    rb_gc_register_mark_object(klass);
 
-    return Qnil;
+    index = profile_class_count++;
+    profile_class_stats[index] = (RBProfileClass){.klass = klass};
+    st_insert(profile_class_index, (st_data_t)klass, index);
+    return &profile_class_stats[index];
 }
 
-static void update_objects(VALUE objects)
+static void profile_class_add(VALUE klass, double seconds)
+{
+    RBProfileClass *stats = profile_class(klass);
+    stats->frame_seconds += seconds;
+    stats->frame_calls++;
+    stats->total_seconds += seconds;
+    stats->total_calls++;
+}
+
+static double profile_frame_total(RBProfileFrame *frame)
+{
+    double total = 0;
+    for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+        total += frame->phases[i];
+    return total;
+}
+
+// stacked bar per recorded frame in the bottom left corner, the line marks a 60 fps frame
+static void profile_draw_overlay(void)
 {
-    for (int i = 0; i < RARRAY_LEN(objects); i++)
+    const int bar_width = 2;
+    const int graph_height = 100;
+    const double scale = graph_height / (2.0 / 60.0); // graph tops out at two 60 fps frames
+    int base_y = window_height - 10;
+    int x = 10;
+
+    DrawRectangle(x - 2, base_y - graph_height - 2, profile_capacity * bar_width + 4, graph_height + 4, Fade(BLACK, 0.6f));
+
+    for (int i = 0; i < profile_count; i++)
     {
-        VALUE obj_val = rb_ary_entry(objects, i);
-        if (rb_obj_is_kind_of(obj_val, game_object_class))
-        {
-            rb_funcall(obj_val, rb_intern("update"), 0);
-        }
-        else
+        RBProfileFrame *frame = &profile_frames[(profile_head - profile_count + i + profile_capacity) % profile_capacity];
+        int y = base_y;
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT && y > base_y - graph_height; phase++)
         {
-            VALUE obj_class = rb_obj_class(obj_val);
-            VALUE class_name = rb_class_name(obj_class);
-            rb_raise(rb_eTypeError, "Attempting to update a %s, which is not a GameObject", StringValueCStr(class_name));
+            int h = (int)(frame->phases[phase] * scale + 0.5);
+            if (h <= 0)
+                continue;
+            if (y - h < base_y - graph_height)
+                h = y - (base_y - graph_height);
+            DrawRectangle(x + i * bar_width, y - h, bar_width, h, profile_phase_colors[phase]);
+            y -= h;
         }
     }
-}
 
-static void draw_objects(VALUE objects)
-{
-    for (int i = 0; i < RARRAY_LEN(objects); i++)
+    int target_y = base_y - graph_height / 2;
+    DrawLine(x, target_y, x + profile_capacity * bar_width, target_y, WHITE);
+
+    if (profile_count > 0)
     {
-        VALUE obj_val = rb_ary_entry(objects, i);
-        if (rb_obj_is_kind_of(obj_val, game_object_class))
-        {
-            VALUE texture_val = rb_iv_get(obj_val, "@texture");
-            RBTexture *tex;
-            TypedData_Get_Struct(texture_val, RBTexture, &texture_type, tex);
+        RBProfileFrame *last = &profile_frames[(profile_head - 1 + profile_capacity) % profile_capacity];
+        DrawText(TextFormat("%.2f ms", profile_frame_total(last) * 1000.0), x, base_y - graph_height - 14, 10, WHITE);
+    }
+}
 
-            VALUE render_props_val = rb_iv_get(obj_val, "@render_props");
-            assert(rb_obj_is_kind_of(render_props_val, render_props_class));
+// background asset loading
+// worker threads only decode files into CPU side Images and Waves, they never touch Ruby or the GPU
+// finished jobs wait in a completion queue until the main thread uploads them during engine_run
 
-            RBRenderProps *props;
-            TypedData_Get_Struct(render_props_val, RBRenderProps, &render_props_type, props);
+#define ASSET_JOB_TEXTURE 0
+#define ASSET_JOB_SOUND 1
+#define ASSET_LOADER_MAX_THREADS 4
 
-            Rectangle src = props->frame;
-            src.width = props->hflip ? -src.width : src.width;
-            src.height = props->vflip ? -src.height : src.height;
+struct RBLoadJob
+{
+    RBLoadJob *next;
+    int kind;
+    char *path;
+    Image image;
+    Wave wave;
+    void *target; // RBTexture or RBSound waiting on this job, NULL if it was garbage collected
+    const RBPackEntry *packed; // set when the asset is in the mounted pack
+    bool decoded;
+};
+
+static pthread_mutex_t loader_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t loader_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t loader_done_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t loader_threads[ASSET_LOADER_MAX_THREADS];
+static int loader_thread_count = 0;
+static bool loader_stopping = false;
+
+static RBLoadJob *loader_pending_head = NULL, *loader_pending_tail = NULL;
+static RBLoadJob *loader_done_head = NULL, *loader_done_tail = NULL;
+
+// progress since the loader was last idle, only touched on the main thread
+static int loader_jobs_total = 0;
+static int loader_jobs_finished = 0;
+
+static void load_job_push(RBLoadJob **head, RBLoadJob **tail, RBLoadJob *job)
+{
+    job->next = NULL;
+    if (*tail)
+        (*tail)->next = job;
+    else
+        *head = job;
+    *tail = job;
+}
 
-            Rectangle dst = {
-                .x = props->x,
-                .y = props->y,
-                .width = props->width,
-                .height = props->height};
-            Vector2 origin = {.x = props->origin_x, .y = props->origin_y};
+static RBLoadJob *load_job_pop(RBLoadJob **head, RBLoadJob **tail)
+{
+    RBLoadJob *job = *head;
+    if (job)
+    {
+        *head = job->next;
+        if (!*head)
+            *tail = NULL;
+    }
+    return job;
+}
 
-            // check if x +(?) origin_x is less than zero or greater than window size, do for y as well
-            // this would have to handle camera zoom and scrolling automatically
-            if ((dst.x >= 0 && dst.x < window_width) && (dst.y >= 0 && dst.y < window_height))
-                DrawTexturePro(tex->texture, src, dst, origin, props->angle, WHITE);
-        }
+static void load_job_unlink(RBLoadJob **head, RBLoadJob **tail, RBLoadJob *job)
+{
+    RBLoadJob *prev = NULL;
+    for (RBLoadJob *it = *head; it; prev = it, it = it->next)
+    {
+        if (it != job)
+            continue;
+        if (prev)
+            prev->next = it->next;
         else
-        {
-            VALUE obj_class = rb_obj_class(obj_val);
-            VALUE class_name = rb_class_name(obj_class);
-            rb_raise(rb_eTypeError, "Attempting to draw a %s, which is not a GameObject", StringValueCStr(class_name));
-        }
+            *head = it->next;
+        if (*tail == it)
+            *tail = prev;
+        return;
     }
 }
 
-static VALUE engine_run(VALUE self)
+static void *loader_thread_main(void *arg)
 {
-    while (!WindowShouldClose())
+    pthread_mutex_lock(&loader_mutex);
+    while (!loader_stopping)
     {
-        VALUE scene = rb_iv_get(engine_class, "@current_scene");
-        if (!rb_obj_is_kind_of(scene, scene_class))
+        RBLoadJob *job = load_job_pop(&loader_pending_head, &loader_pending_tail);
+        if (!job)
         {
-            rb_raise(rb_eTypeError, "Internal error: No active scene. There might be an issue with your config.rb, or your scene switching logic.");
+            pthread_cond_wait(&loader_work_cond, &loader_mutex);
+            continue;
         }
 
-        // fetch the current scene's objects
-        VALUE objects = rb_iv_get(scene, "@objects");
-        Check_Type(objects, T_ARRAY);
+        // decoding is the slow part, do it without holding the lock
+        pthread_mutex_unlock(&loader_mutex);
+        if (job->kind == ASSET_JOB_TEXTURE)
+            job->image = LoadImage(job->path);
+        else if (job->packed)
+            job->wave = pack_decode_wave(job->packed);
+        else
+            job->wave = LoadWave(job->path);
+        pthread_mutex_lock(&loader_mutex);
 
-        VALUE ui_objects = rb_iv_get(scene, "@ui_objects");
-        Check_Type(ui_objects, T_ARRAY);
+        job->decoded = true;
+        load_job_push(&loader_done_head, &loader_done_tail, job);
+        pthread_cond_broadcast(&loader_done_cond);
+    }
+    pthread_mutex_unlock(&loader_mutex);
+    return NULL;
+}
 
-        // handle inputs
-        VALUE inputs = rb_iv_get(input_class, "@inputs");
-        Check_Type(inputs, T_HASH);
-        rb_hash_foreach(inputs, inputs_foreach_callback, Qnil);
+static void loader_start(void)
+{
+    if (loader_thread_count > 0)
+        return;
 
-        if (current_music)
-            UpdateMusicStream(current_music->music);
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int count = cores > 2 ? (int)cores - 1 : 1; // leave a core for the main thread
+    if (count > ASSET_LOADER_MAX_THREADS)
+        count = ASSET_LOADER_MAX_THREADS;
 
-        // update loop
-        update_objects(objects);
-        update_objects(ui_objects);
-        rb_funcall(scene, rb_intern("update"), 0);
+    loader_stopping = false;
+    for (int i = 0; i < count; i++)
+    {
+        if (pthread_create(&loader_threads[i], NULL, loader_thread_main, NULL) != 0)
+            break;
+        loader_thread_count++;
+    }
 
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
+    if (loader_thread_count == 0)
+        rb_raise(rb_eRuntimeError, "Failed to start asset loader threads");
+}
 
-        // fetch camera from scene, will raise error if no camera object exists
-        VALUE camera_val = rb_iv_get(scene, "@camera");
-        TypedData_Get_Struct(camera_val, Camera2D, &camera_type, cam);
-        BeginMode2D(*cam);
+static void loader_stop(void)
+{
+    pthread_mutex_lock(&loader_mutex);
+    loader_stopping = true;
+    pthread_cond_broadcast(&loader_work_cond);
+    pthread_mutex_unlock(&loader_mutex);
+
+    for (int i = 0; i < loader_thread_count; i++)
+        pthread_join(loader_threads[i], NULL);
+    loader_thread_count = 0;
+}
 
-        // draw loop
-        draw_objects(objects);
+static RBLoadJob *loader_enqueue(int kind, VALUE path, void *target)
+{
+    RBLoadJob *job = ALLOC(RBLoadJob);
+    *job = (RBLoadJob){.kind = kind, .target = target};
+    job->path = ruby_strdup(StringValueCStr(path));
+    job->packed = pack_find(job->path);
+
+    // a new batch after the loader went idle restarts progress from zero
+    if (loader_jobs_finished == loader_jobs_total)
+        loader_jobs_total = loader_jobs_finished = 0;
+    loader_jobs_total++;
+
+    // packed images and waves are already decoded, they skip the threads and wait for their upload
+    bool mapped = job->packed && job->packed->kind == (kind == ASSET_JOB_TEXTURE ? PACK_IMAGE : PACK_WAVE);
+    if (mapped)
+    {
+        if (kind == ASSET_JOB_TEXTURE)
+            job->image = pack_image(job->packed);
+        else
+            job->wave = pack_wave(job->packed);
+        job->decoded = true;
+    }
+    else
+    {
+        loader_start();
+    }
 
-        // debug drawing
-        VALUE debug_rects_val = rb_iv_get(debug_class, "@rects");
-        Check_Type(debug_rects_val, T_ARRAY);
+    pthread_mutex_lock(&loader_mutex);
+    if (mapped)
+    {
+        load_job_push(&loader_done_head, &loader_done_tail, job);
+        pthread_cond_broadcast(&loader_done_cond);
+    }
+    else
+    {
+        load_job_push(&loader_pending_head, &loader_pending_tail, job);
+        pthread_cond_signal(&loader_work_cond);
+    }
+    pthread_mutex_unlock(&loader_mutex);
+    return job;
+}
 
-        for (int i = 0; i < RARRAY_LEN(debug_rects_val); i++)
+// called when the handle waiting on a job is freed, the upload step then just discards the decoded data
+static void loader_detach(RBLoadJob *job)
+{
+    pthread_mutex_lock(&loader_mutex);
+    job->target = NULL;
+    pthread_mutex_unlock(&loader_mutex);
+}
+
+// turns a decoded job into GPU textures or audio buffers, main thread only, the job must be off every queue
+static void loader_upload(RBLoadJob *job)
+{
+    double start = now_seconds();
+    if (job->kind == ASSET_JOB_TEXTURE)
+    {
+        RBTexture *tex = (RBTexture *)job->target;
+        if (tex)
         {
-            VALUE obj_val = rb_ary_entry(debug_rects_val, i);
-            if (rb_obj_is_kind_of(obj_val, rect_class))
-            {
-                Rectangle *rect;
-                TypedData_Get_Struct(obj_val, Rectangle, &rect_type, rect);
-                DrawRectangleLinesEx(*rect, 1, RED);
-            }
-            else
-            {
-                VALUE obj_class = rb_obj_class(obj_val);
-                VALUE class_name = rb_class_name(obj_class);
-                rb_raise(rb_eTypeError, "Attempting to debug draw a %s, which is not a Rect", StringValueCStr(class_name));
-            }
+            tex->texture = texture_from_image(job->image);
+            texture_id_changes++;
+            tex->region = (Rectangle){0, 0, tex->texture.width, tex->texture.height};
+            tex->job = NULL;
+            asset_set_bytes(&tex->info, texture_bytes(tex->texture));
+        }
+        if (!job->packed || job->packed->kind != PACK_IMAGE)
+            UnloadImage(job->image);
+    }
+    else
+    {
+        RBSound *sound = (RBSound *)job->target;
+        if (sound)
+        {
+            sound->sound = sound_from_wave(job->wave);
+            sound->job = NULL;
+            asset_set_bytes(&sound->info, sound_bytes(sound->sound));
         }
+        if (!job->packed || job->packed->kind != PACK_WAVE)
+            UnloadWave(job->wave);
+    }
 
-        EndMode2D();
+    loader_jobs_finished++;
+    asset_stats_record(start, job->path);
+    ruby_xfree(job->path);
+    ruby_xfree(job);
+}
 
-        // UI drawing (no camera transforms)
-        draw_objects(ui_objects);
+static void *loader_wait_for_job(void *arg)
+{
+    RBLoadJob *job = (RBLoadJob *)arg;
+    pthread_mutex_lock(&loader_mutex);
+    while (!job->decoded)
+        pthread_cond_wait(&loader_done_cond, &loader_mutex);
+    load_job_unlink(&loader_done_head, &loader_done_tail, job);
+    pthread_mutex_unlock(&loader_mutex);
+    return NULL;
+}
+
+static void *loader_wait_for_any(void *arg)
+{
+    pthread_mutex_lock(&loader_mutex);
+    while (!loader_done_head)
+        pthread_cond_wait(&loader_done_cond, &loader_mutex);
+    pthread_mutex_unlock(&loader_mutex);
+    return NULL;
+}
+
+// blocks until a specific job is decoded and uploads it right away, used when an async asset is needed now
+static void loader_finish(RBLoadJob *job)
+{
+    rb_thread_call_without_gvl(loader_wait_for_job, job, NULL, NULL);
+    loader_upload(job);
+}
+
+// uploads finished jobs until the per frame budget runs out, always makes progress on at least one job
+static void loader_process_completed(double budget)
+{
+    double start = now_seconds();
+    do
+    {
+        pthread_mutex_lock(&loader_mutex);
+        RBLoadJob *job = load_job_pop(&loader_done_head, &loader_done_tail);
+        pthread_mutex_unlock(&loader_mutex);
+
+        if (!job)
+            return;
+        loader_upload(job);
+    } while (now_seconds() - start < budget);
+}
+
+static void texture_ensure_loaded(RBTexture *tex)
+{
+    if (tex->job)
+        loader_finish(tex->job);
+}
+
+static void sound_ensure_loaded(RBSound *sound)
+{
+    if (sound->job)
+        loader_finish(sound->job);
+}
+
+static void texture_mark(void *ptr)
+{
+    RBTexture *tex = (RBTexture *)ptr;
+    rb_gc_mark(tex->page);
+}
+
+static void texture_free(void *ptr)
+{
+    RBTexture *tex = (RBTexture *)ptr;
+    if (tex->job)
+        loader_detach(tex->job);
+    if (tex->owned && tex->texture.id != 0)
+        UnloadTexture(tex->texture);
+    asset_set_bytes(&tex->info, 0);
+    ruby_xfree(ptr);
+}
+
+static const rb_data_type_t texture_type =
+    {
+        "RBScene::Texture",
+        {texture_mark, texture_free, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+// music streams are refilled on their own thread so a long frame can't starve them
+// the main thread only sends commands through a single producer, single consumer ring, every caller holds the GVL
+// the thread owns a stream from its first play until it's unloaded, the main thread never touches it again
+
+#define MUSIC_QUEUE_SIZE 64         // power of two
+#define MUSIC_TRACKS 2              // the current track and the one fading out under it
+#define MUSIC_BUFFER_FRAMES 1024    // per stream sub-buffer, small since refills no longer wait for a frame
+#define MUSIC_REFILL_INTERVAL 0.005 // seconds the thread sleeps between refills
+
+enum
+{
+    MUSIC_CMD_PLAY,
+    MUSIC_CMD_STOP,
+    MUSIC_CMD_VOLUME,
+    MUSIC_CMD_UNLOAD,
+    MUSIC_CMD_QUIT
+};
+
+typedef struct
+{
+    int type;
+    unsigned int id;
+    Music music;
+    float volume;
+    float fade; // seconds
+} RBMusicCommand;
+
+typedef struct
+{
+    Music music;
+    unsigned int id;
+    bool active;
+    bool stopping; // stopped once its fade reaches silence
+    float volume;
+    float target;
+    float rate; // volume change per second while fading
+    double last_refill;
+} RBMusicTrack;
+
+static RBMusicCommand music_queue[MUSIC_QUEUE_SIZE];
+static atomic_uint music_queue_head = 0; // next slot the main thread writes
+static atomic_uint music_queue_tail = 0; // next slot the audio thread reads
+static pthread_t music_thread;
+static bool music_thread_running = false;
+static unsigned int music_next_id = 1;
+
+// the tracks the audio thread was last told to play, held so they aren't evicted or freed mid song or mid fade
+static VALUE music_playing = Qnil;
+static VALUE music_fading = Qnil;
+
+// only touched by the audio thread
+static RBMusicTrack music_tracks[MUSIC_TRACKS];
+static float music_master_volume = 1.0f;
+
+static atomic_long music_stats_refills = 0;
+static atomic_long music_stats_underruns = 0; // refills that came after the stream had played everything it had buffered
+static atomic_long music_stats_commands = 0;
+static atomic_long music_stats_fades = 0; // volume ramps that reached their target, fading out to a stop included
+static atomic_long music_stats_stops = 0; // tracks stopped once they faded out
+
+static void music_track_fade(RBMusicTrack *track, float target, float seconds, bool stopping)
+{
+    track->target = target;
+    track->stopping = stopping;
+    track->rate = seconds > 0 ? fabsf(target - track->volume) / seconds : INFINITY;
+}
+
+static void music_track_stop(RBMusicTrack *track)
+{
+    if (track->music.stream.buffer)
+        StopMusicStream(track->music);
+    track->active = false;
+}
 
-        EndDrawing();
+static void music_thread_play(RBMusicCommand *cmd)
+{
+    RBMusicTrack *current = &music_tracks[0];
+    RBMusicTrack *fading = &music_tracks[1];
+    if (fading->active && fading->id == cmd->id)
+    {
+        // coming back to the track that was fading out, bring it back up where it is
+        RBMusicTrack swap = *current;
+        *current = *fading;
+        *fading = swap;
+        if (fading->active)
+            music_track_fade(fading, 0, cmd->fade, true);
+    }
+    if (current->active && current->id == cmd->id)
+    {
+        music_track_fade(current, cmd->volume, cmd->fade, false);
+        return;
     }
 
-    // should not need to clean up loaded textures and audio, when Ruby closes they should be GC'd
-    CloseAudioDevice();
-    CloseWindow();
-    return Qnil;
+    // the old track moves to the fading slot, cutting off anything still fading there
+    if (fading->active)
+        music_track_stop(fading);
+    *fading = *current;
+    if (fading->active)
+        music_track_fade(fading, 0, cmd->fade, true);
+
+    *current = (RBMusicTrack){.music = cmd->music, .id = cmd->id, .active = true, .volume = cmd->fade > 0 ? 0 : cmd->volume};
+    music_track_fade(current, cmd->volume, cmd->fade, false);
+    if (current->music.stream.buffer)
+    {
+        SetMusicVolume(current->music, current->volume * music_master_volume);
+        PlayMusicStream(current->music);
+    }
 }
 
-static VALUE assets_load_texture(VALUE self, VALUE filename)
+static bool music_thread_command(RBMusicCommand *cmd)
 {
-    Check_Type(filename, T_STRING);
+    atomic_fetch_add_explicit(&music_stats_commands, 1, memory_order_relaxed);
+    switch (cmd->type)
+    {
+    case MUSIC_CMD_PLAY:
+        music_thread_play(cmd);
+        break;
+    case MUSIC_CMD_STOP:
+        for (int i = 0; i < MUSIC_TRACKS; i++)
+        {
+            if (music_tracks[i].active)
+                music_track_fade(&music_tracks[i], 0, cmd->fade, true);
+        }
+        break;
+    case MUSIC_CMD_VOLUME:
+        music_master_volume = cmd->volume;
+        break;
+    case MUSIC_CMD_UNLOAD:
+        for (int i = 0; i < MUSIC_TRACKS; i++)
+        {
+            if (music_tracks[i].active && music_tracks[i].id == cmd->id)
+                music_track_stop(&music_tracks[i]);
+        }
+        if (cmd->music.stream.buffer)
+            UnloadMusicStream(cmd->music);
+        break;
+    case MUSIC_CMD_QUIT:
+        return false;
+    }
+    return true;
+}
 
-    VALUE cache_val = rb_iv_get(self, "@textures");
-    Check_Type(cache_val, T_HASH);
+static void music_thread_update(RBMusicTrack *track, double now, double dt)
+{
+    if (track->volume != track->target)
+    {
+        float step = track->rate * (float)dt;
+        if (fabsf(track->target - track->volume) <= step)
+        {
+            track->volume = track->target;
+            atomic_fetch_add_explicit(&music_stats_fades, 1, memory_order_relaxed);
+        }
+        else
+            track->volume += track->target > track->volume ? step : -step;
+    }
+    if (track->stopping && track->volume <= 0)
+    {
+        music_track_stop(track);
+        atomic_fetch_add_explicit(&music_stats_stops, 1, memory_order_relaxed);
+        return;
+    }
+    if (!track->music.stream.buffer)
+        return;
+
+    // the stream holds two sub-buffers, a longer gap means it ran dry
+    double buffered = 2.0 * MUSIC_BUFFER_FRAMES / (track->music.stream.sampleRate ? track->music.stream.sampleRate : 44100);
+    if (track->last_refill > 0 && now - track->last_refill > buffered)
+        atomic_fetch_add_explicit(&music_stats_underruns, 1, memory_order_relaxed);
+    track->last_refill = now;
+
+    SetMusicVolume(track->music, track->volume * music_master_volume);
+    UpdateMusicStream(track->music);
+    atomic_fetch_add_explicit(&music_stats_refills, 1, memory_order_relaxed);
+}
 
-    VALUE texture_val = rb_hash_lookup(cache_val, filename);
-    assert(rb_obj_is_kind_of(texture_val, texture_class));
+static void *music_thread_main(void *arg)
+{
+    double last = now_seconds();
+    for (;;)
+    {
+        unsigned int head = atomic_load_explicit(&music_queue_head, memory_order_acquire);
+        unsigned int tail = atomic_load_explicit(&music_queue_tail, memory_order_relaxed);
+        for (; tail != head; tail++)
+        {
+            bool running = music_thread_command(&music_queue[tail & (MUSIC_QUEUE_SIZE - 1)]);
+            atomic_store_explicit(&music_queue_tail, tail + 1, memory_order_release);
+            if (!running)
+                return NULL;
+        }
 
-    if (texture_val == Qnil)
+        double now = now_seconds();
+        for (int i = 0; i < MUSIC_TRACKS; i++)
+        {
+            if (music_tracks[i].active)
+                music_thread_update(&music_tracks[i], now, now - last);
+        }
+        last = now;
+
+        struct timespec sleep = {0, (long)(MUSIC_REFILL_INTERVAL * 1e9)};
+        nanosleep(&sleep, NULL);
+    }
+}
+
+static void music_send(RBMusicCommand cmd)
+{
+    if (!music_thread_running)
     {
-        // cache doesn't have an entry at this key, make a new one
-        RBTexture *tex;
-        texture_val = TypedData_Make_Struct(texture_class, RBTexture, &texture_type, tex);
-        tex->texture = LoadTexture(StringValueCStr(filename));
-        // TODO: should raise error if texture loading failed
-        rb_hash_aset(cache_val, filename, texture_val);
+        if (pthread_create(&music_thread, NULL, music_thread_main, NULL) != 0)
+            rb_raise(rb_eRuntimeError, "Failed to start the music thread");
+        music_thread_running = true;
     }
 
-    // if cache already has this entry, just return it
-    return texture_val;
+    unsigned int head = atomic_load_explicit(&music_queue_head, memory_order_relaxed);
+    // a full queue drains within one refill interval
+    while (head - atomic_load_explicit(&music_queue_tail, memory_order_acquire) == MUSIC_QUEUE_SIZE)
+        sched_yield();
+    music_queue[head & (MUSIC_QUEUE_SIZE - 1)] = cmd;
+    atomic_store_explicit(&music_queue_head, head + 1, memory_order_release);
 }
 
-static VALUE assets_load_sound(VALUE self, VALUE filename)
+// stops and joins the thread, streams it was playing stay loaded until their Music is freed
+static void music_thread_stop(void)
 {
-    Check_Type(filename, T_STRING);
+    if (!music_thread_running)
+        return;
+    music_send((RBMusicCommand){.type = MUSIC_CMD_QUIT});
+    pthread_join(music_thread, NULL);
+    music_thread_running = false;
+}
 
-    VALUE cache_val = rb_iv_get(self, "@sounds");
-    Check_Type(cache_val, T_HASH);
+static void music_free(void *ptr)
+{
+    RBMusic *music = (RBMusic *)ptr;
+    // once the thread has seen a stream only it may unload it
+    if (music_thread_running)
+        music_send((RBMusicCommand){.type = MUSIC_CMD_UNLOAD, .id = music->id, .music = music->music});
+    else if (music->music.stream.buffer)
+        UnloadMusicStream(music->music);
+    asset_set_bytes(&music->info, 0);
+    ruby_xfree(ptr);
+}
 
-    VALUE sound_val = rb_hash_lookup(cache_val, filename);
-    assert(rb_obj_is_kind_of(sound_val, sound_class));
+static const rb_data_type_t music_type =
+    {
+        "RBScene::Music",
+        {0, music_free, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
 
-    if (sound_val == Qnil)
+// every playing voice across all sounds, so the global cap can pick one to steal without walking the sounds
+typedef struct
+{
+    RBSound *sound;
+    int voice;
+} RBVoice;
+
+static RBVoice active_voices[AUDIO_VOICE_LIMIT];
+static int active_voice_count = 0;
+static int max_active_voices = 32;
+static long audio_stats_played = 0;
+static long audio_stats_stolen = 0;  // voices cut off to make room for a new one
+static long audio_stats_dropped = 0; // plays skipped because every voice belonged to a higher priority sound
+
+static Sound *sound_voice(RBSound *sound, int voice)
+{
+    return voice == 0 ? &sound->sound : &sound->aliases[voice - 1];
+}
+
+static void voice_release(int index)
+{
+    RBVoice voice = active_voices[index];
+    voice.sound->voice_started[voice.voice] = 0;
+    active_voices[index] = active_voices[--active_voice_count];
+}
+
+static void voice_stop(int index)
+{
+    RBVoice voice = active_voices[index];
+    StopSound(*sound_voice(voice.sound, voice.voice));
+    voice_release(index);
+}
+
+static int voice_index(RBSound *sound, int voice)
+{
+    for (int i = 0; i < active_voice_count; i++)
     {
-        // cache doesn't have an entry at this key, make a new one
-        RBSound *sound;
-        sound_val = TypedData_Make_Struct(sound_class, RBSound, &sound_type, sound);
-        sound->sound = LoadSound(StringValueCStr(filename));
-        // TODO: should raise error if sound loading failed
-        rb_hash_aset(cache_val, filename, sound_val);
+        if (active_voices[i].sound == sound && active_voices[i].voice == voice)
+            return i;
     }
+    return -1;
+}
 
-    // if cache already has this entry, just return it
-    return sound_val;
+// forgets voices that finished playing, once a frame and whenever a cap is reached
+static void audio_reap(RBSound *only)
+{
+    for (int i = active_voice_count - 1; i >= 0; i--)
+    {
+        RBVoice voice = active_voices[i];
+        if ((!only || voice.sound == only) && !IsSoundPlaying(*sound_voice(voice.sound, voice.voice)))
+            voice_release(i);
+    }
+}
+
+static void sound_stop_voices(RBSound *sound)
+{
+    for (int i = active_voice_count - 1; i >= 0; i--)
+    {
+        if (active_voices[i].sound == sound)
+            voice_stop(i);
+    }
+}
+
+static void sound_free(void *ptr)
+{
+    RBSound *sound = (RBSound *)ptr;
+    if (sound->job)
+        loader_detach(sound->job);
+    sound_stop_voices(sound);
+    for (int i = 0; i < sound->alias_count; i++)
+        UnloadSoundAlias(sound->aliases[i]);
+    if (sound->sound.stream.buffer)
+        UnloadSound(sound->sound);
+    asset_set_bytes(&sound->info, 0);
+    ruby_xfree(ptr);
+}
+
+static const rb_data_type_t sound_type =
+    {
+        "RBScene::Sound",
+        {0, sound_free, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+static RBAssetInfo *asset_info(VALUE asset)
+{
+    if (rb_typeddata_is_kind_of(asset, &texture_type))
+        return &((RBTexture *)RTYPEDDATA_DATA(asset))->info;
+    if (rb_typeddata_is_kind_of(asset, &sound_type))
+        return &((RBSound *)RTYPEDDATA_DATA(asset))->info;
+    return &((RBMusic *)RTYPEDDATA_DATA(asset))->info;
+}
+
+// every load, hit or miss, counts as a use by the scene that's current, see Assets.enter_scene
+static void asset_use(VALUE asset, bool hit)
+{
+    RBAssetInfo *info = asset_info(asset);
+    info->last_used = now_seconds();
+    if (hit)
+        asset_stats_hits++;
+
+    VALUE scope = rb_iv_get(assets_class, "@scope");
+    if (NIL_P(scope))
+    {
+        if (!info->pinned)
+            info->refs++;
+        info->pinned = true;
+    }
+    else if (!RTEST(rb_hash_lookup(scope, asset)))
+    {
+        rb_hash_aset(scope, asset, Qtrue);
+        info->refs++;
+    }
+}
+
+typedef struct
+{
+    VALUE cache;
+    VALUE key;
+    RBAssetInfo *info;
+} RBEvictCandidate;
+
+typedef struct
+{
+    VALUE cache;
+    RBEvictCandidate *items;
+    long count;
+    long capacity;
+} RBEvictList;
+
+static int asset_collect_unused(VALUE key, VALUE asset, VALUE arg)
+{
+    RBEvictList *list = (RBEvictList *)arg;
+    RBAssetInfo *info = asset_info(asset);
+    if (info->refs > 0 || asset == music_playing || asset == music_fading)
+        return ST_CONTINUE;
+
+    if (list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        REALLOC_N(list->items, RBEvictCandidate, list->capacity);
+    }
+    list->items[list->count++] = (RBEvictCandidate){list->cache, key, info};
+    return ST_CONTINUE;
+}
+
+static int compare_evict_candidate(const void *a, const void *b)
+{
+    double x = ((const RBEvictCandidate *)a)->info->last_used;
+    double y = ((const RBEvictCandidate *)b)->info->last_used;
+    return (x > y) - (x < y);
+}
+
+// drops unused assets from the caches until they fit in budget, the memory goes when GC frees them
+static void asset_trim(size_t budget)
+{
+    if (asset_cached_bytes <= budget)
+        return;
+
+    static const char *caches[] = {"@textures", "@sounds", "@music"};
+    RBEvictList list = {0};
+    for (int i = 0; i < 3; i++)
+    {
+        list.cache = rb_iv_get(assets_class, caches[i]);
+        rb_hash_foreach(list.cache, asset_collect_unused, (VALUE)&list);
+    }
+    qsort(list.items, list.count, sizeof(RBEvictCandidate), compare_evict_candidate);
+
+    for (long i = 0; i < list.count && asset_cached_bytes > budget; i++)
+    {
+        RBEvictCandidate candidate = list.items[i];
+        rb_hash_delete(candidate.cache, candidate.key);
+        asset_cached_bytes -= candidate.info->bytes;
+        candidate.info->cached = false;
+        asset_stats_evicted++;
+    }
+    ruby_xfree(list.items);
+}
+
+static void asset_cache(VALUE cache, VALUE key, VALUE asset)
+{
+    RBAssetInfo *info = asset_info(asset);
+    rb_hash_aset(cache, key, asset);
+    info->cached = true;
+    asset_cached_bytes += info->bytes;
+    asset_use(asset, false);
+    asset_trim(asset_budget);
+}
+
+static RBRenderPool render_pool = {0, 0, -1, NULL};
+
+// slots whose bounds need recomputing before the next draw
+static int *dirty_slots = NULL;
+static int dirty_count = 0;
+static int dirty_capacity = 0;
+
+static void render_pool_grow(void)
+{
+    int capacity = render_pool.capacity ? render_pool.capacity * 2 : 256;
+
+    REALLOC_N(render_pool.next_free, int, capacity);
+    REALLOC_N(render_pool.x, float, capacity);
+    REALLOC_N(render_pool.y, float, capacity);
+    REALLOC_N(render_pool.prev_x, float, capacity);
+    REALLOC_N(render_pool.prev_y, float, capacity);
+    REALLOC_N(render_pool.width, float, capacity);
+    REALLOC_N(render_pool.height, float, capacity);
+    REALLOC_N(render_pool.angle, float, capacity);
+    REALLOC_N(render_pool.frame, Rectangle, capacity);
+    REALLOC_N(render_pool.hflip, bool, capacity);
+    REALLOC_N(render_pool.vflip, bool, capacity);
+    REALLOC_N(render_pool.origin_x, float, capacity);
+    REALLOC_N(render_pool.origin_y, float, capacity);
+    REALLOC_N(render_pool.texture, RBTexture *, capacity);
+    REALLOC_N(render_pool.layer, int, capacity);
+    REALLOC_N(render_pool.z, float, capacity);
+    REALLOC_N(render_pool.is_static, bool, capacity);
+    REALLOC_N(render_pool.bounds, Rectangle, capacity);
+    REALLOC_N(render_pool.dirty, bool, capacity);
+    REALLOC_N(render_pool.seq, unsigned int, capacity);
+    REALLOC_N(render_pool.visit, unsigned int, capacity);
+    REALLOC_N(render_pool.cells, RBCellRange, capacity);
+    REALLOC_N(render_pool.owner, RBDrawList *, capacity);
+    REALLOC_N(render_pool.list_index, int, capacity);
+    REALLOC_N(render_pool.body, int, capacity);
+    REALLOC_N(render_pool.body_world, RBCollisionWorld *, capacity);
+
+    render_pool.capacity = capacity;
+}
+
+static int render_pool_alloc(void)
+{
+    int slot;
+    if (render_pool.free_head >= 0)
+    {
+        slot = render_pool.free_head;
+        render_pool.free_head = render_pool.next_free[slot];
+    }
+    else
+    {
+        if (render_pool.count == render_pool.capacity)
+            render_pool_grow();
+        slot = render_pool.count++;
+    }
+
+    render_pool.next_free[slot] = -1;
+    render_pool.x[slot] = render_pool.prev_x[slot] = 0;
+    render_pool.y[slot] = render_pool.prev_y[slot] = 0;
+    render_pool.dirty[slot] = false;
+    render_pool.seq[slot] = 0;
+    render_pool.layer[slot] = 0;
+    render_pool.z[slot] = 0;
+    render_pool.is_static[slot] = false;
+    render_pool.visit[slot] = 0;
+    render_pool.cells[slot] = (RBCellRange){0};
+    render_pool.owner[slot] = NULL;
+    render_pool.body[slot] = -1;
+    render_pool.body_world[slot] = NULL;
+    return slot;
+}
+
+static void render_pool_release(int slot)
+{
+    render_pool.texture[slot] = NULL;
+    render_pool.dirty[slot] = false;
+    render_pool.next_free[slot] = render_pool.free_head;
+    render_pool.free_head = slot;
+}
+
+// taken before every simulation step, free slots are copied too since that's cheaper than skipping them
+static void render_pool_snapshot(void)
+{
+    memcpy(render_pool.prev_x, render_pool.x, render_pool.count * sizeof(float));
+    memcpy(render_pool.prev_y, render_pool.y, render_pool.count * sizeof(float));
+}
+
+static bool slot_is_static(RBDrawList *list, int slot)
+{
+    if (render_pool.is_static[slot])
+        return true;
+    for (int i = 0; i < list->static_layer_count; i++)
+    {
+        if (list->static_layers[i] == render_pool.layer[slot])
+            return true;
+    }
+    return false;
+}
+
+static RBStaticCache *static_cache_for(RBDrawList *list, int layer)
+{
+    int i = 0;
+    while (i < list->static_count && list->statics[i].layer < layer)
+        i++;
+    if (i < list->static_count && list->statics[i].layer == layer)
+        return &list->statics[i];
+
+    REALLOC_N(list->statics, RBStaticCache, list->static_count + 1);
+    memmove(&list->statics[i + 1], &list->statics[i], (list->static_count - i) * sizeof(RBStaticCache));
+    list->statics[i] = (RBStaticCache){.layer = layer, .dirty = true};
+    list->static_count++;
+    return &list->statics[i];
+}
+
+static void static_cache_unload(RBStaticCache *cache)
+{
+    if (!cache->chunks)
+        return;
+    for (int i = 0; i < cache->chunk_cols * cache->chunk_rows; i++)
+    {
+        if (cache->chunks[i].loaded)
+            UnloadRenderTexture(cache->chunks[i].target);
+    }
+    xfree(cache->chunks);
+    cache->chunks = NULL;
+}
+
+// anything that changes how a static sprite looks, or which sprites are static, rebakes its layer
+static void static_cache_mark(int slot)
+{
+    RBDrawList *list = render_pool.owner[slot];
+    if (list && slot_is_static(list, slot))
+        static_cache_for(list, render_pool.layer[slot])->dirty = true;
+}
+
+// called by every setter that moves, resizes or rotates a slot
+static void render_pool_touch(int slot)
+{
+    static_cache_mark(slot);
+    if (render_pool.dirty[slot])
+        return;
+
+    if (dirty_count == dirty_capacity)
+    {
+        dirty_capacity = dirty_capacity ? dirty_capacity * 2 : 256;
+        REALLOC_N(dirty_slots, int, dirty_capacity);
+    }
+    dirty_slots[dirty_count++] = slot;
+    render_pool.dirty[slot] = true;
+}
+
+// world space bounding box of a sprite, taking origin and rotation into account like DrawTexturePro does
+static Rectangle render_pool_compute_bounds(int slot)
+{
+    float x = render_pool.x[slot];
+    float y = render_pool.y[slot];
+    float w = fabsf(render_pool.width[slot]);
+    float h = fabsf(render_pool.height[slot]);
+    float ox = render_pool.origin_x[slot];
+    float oy = render_pool.origin_y[slot];
+    float angle = render_pool.angle[slot];
+
+    if (angle == 0)
+        return (Rectangle){.x = x - ox, .y = y - oy, .width = w, .height = h};
+
+    float rad = angle * DEG2RAD;
+    float c = cosf(rad);
+    float s = sinf(rad);
+    float corners[4][2] = {{-ox, -oy}, {w - ox, -oy}, {w - ox, h - oy}, {-ox, h - oy}};
+
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (int i = 0; i < 4; i++)
+    {
+        float cx = x + corners[i][0] * c - corners[i][1] * s;
+        float cy = y + corners[i][0] * s + corners[i][1] * c;
+        min_x = fminf(min_x, cx);
+        min_y = fminf(min_y, cy);
+        max_x = fmaxf(max_x, cx);
+        max_y = fmaxf(max_y, cy);
+    }
+    return (Rectangle){.x = min_x, .y = min_y, .width = max_x - min_x, .height = max_y - min_y};
+}
+
+static bool rects_overlap(Rectangle a, Rectangle b)
+{
+    return a.x < b.x + b.width && a.x + a.width > b.x && a.y < b.y + b.height && a.y + a.height > b.y;
+}
+
+static void grid_cell_add(RBGridCell *cell, int slot)
+{
+    if (cell->count == cell->capacity)
+    {
+        cell->capacity = cell->capacity ? cell->capacity * 2 : 8;
+        REALLOC_N(cell->slots, int, cell->capacity);
+    }
+    cell->slots[cell->count++] = slot;
+}
+
+static void grid_cell_remove(RBGridCell *cell, int slot)
+{
+    // order inside a cell doesn't matter, query results are sorted by draw order afterwards
+    for (int i = 0; i < cell->count; i++)
+    {
+        if (cell->slots[i] == slot)
+        {
+            cell->slots[i] = cell->slots[--cell->count];
+            return;
+        }
+    }
+}
+
+static RBSpatialGrid *grid_new(float cell_size)
+{
+    RBSpatialGrid *grid = ALLOC(RBSpatialGrid);
+    *grid = (RBSpatialGrid){0};
+    grid->cell_size = cell_size;
+    return grid;
+}
+
+static void grid_free(RBSpatialGrid *grid)
+{
+    for (int i = 0; i < grid->table_count; i++)
+        ruby_xfree(grid->cells[i].slots);
+    ruby_xfree(grid->oversize.slots);
+    ruby_xfree(grid->keys);
+    ruby_xfree(grid->cell_index);
+    ruby_xfree(grid->cells);
+    ruby_xfree(grid);
+}
+
+static long long grid_key(int cx, int cy)
+{
+    return ((long long)cx << 32) | (unsigned int)cy;
+}
+
+static unsigned int grid_hash(long long key)
+{
+    unsigned long long h = (unsigned long long)key * 0x9E3779B97F4A7C15ULL;
+    return (unsigned int)(h >> 32);
+}
+
+static void grid_rehash(RBSpatialGrid *grid)
+{
+    int capacity = grid->table_capacity ? grid->table_capacity * 2 : 256;
+    long long *keys = ALLOC_N(long long, capacity);
+    int *cell_index = ALLOC_N(int, capacity);
+    for (int i = 0; i < capacity; i++)
+        cell_index[i] = -1;
+
+    for (int i = 0; i < grid->table_capacity; i++)
+    {
+        if (grid->cell_index[i] < 0)
+            continue;
+        unsigned int h = grid_hash(grid->keys[i]) & (capacity - 1);
+        while (cell_index[h] >= 0)
+            h = (h + 1) & (capacity - 1);
+        keys[h] = grid->keys[i];
+        cell_index[h] = grid->cell_index[i];
+    }
+
+    ruby_xfree(grid->keys);
+    ruby_xfree(grid->cell_index);
+    grid->keys = keys;
+    grid->cell_index = cell_index;
+    REALLOC_N(grid->cells, RBGridCell, capacity / 2);
+    grid->table_capacity = capacity;
+}
+
+// finds the cell at the given coordinates, creates it if create is true, otherwise returns NULL when missing
+static RBGridCell *grid_cell(RBSpatialGrid *grid, int cx, int cy, bool create)
+{
+    long long key = grid_key(cx, cy);
+
+    if (grid->table_capacity)
+    {
+        unsigned int h = grid_hash(key) & (grid->table_capacity - 1);
+        while (grid->cell_index[h] >= 0)
+        {
+            if (grid->keys[h] == key)
+                return &grid->cells[grid->cell_index[h]];
+            h = (h + 1) & (grid->table_capacity - 1);
+        }
+    }
+
+    if (!create)
+        return NULL;
+
+    // cells are never removed, keep the table at most half full
+    if (grid->table_count >= grid->table_capacity / 2)
+        grid_rehash(grid);
+
+    unsigned int h = grid_hash(key) & (grid->table_capacity - 1);
+    while (grid->cell_index[h] >= 0)
+        h = (h + 1) & (grid->table_capacity - 1);
+
+    grid->keys[h] = key;
+    grid->cell_index[h] = grid->table_count;
+    grid->cells[grid->table_count] = (RBGridCell){0};
+    return &grid->cells[grid->table_count++];
+}
+
+// objects covering more cells than this in either direction go in the oversize list instead
+#define GRID_MAX_SPAN 16
+
+static RBCellRange grid_range(RBSpatialGrid *grid, Rectangle bounds)
+{
+    RBCellRange range = {
+        .x0 = (int)floorf(bounds.x / grid->cell_size),
+        .y0 = (int)floorf(bounds.y / grid->cell_size),
+        .x1 = (int)floorf((bounds.x + bounds.width) / grid->cell_size),
+        .y1 = (int)floorf((bounds.y + bounds.height) / grid->cell_size),
+        .inserted = true};
+    range.oversize = range.x1 - range.x0 >= GRID_MAX_SPAN || range.y1 - range.y0 >= GRID_MAX_SPAN;
+    return range;
+}
+
+static void grid_insert(RBSpatialGrid *grid, int slot)
+{
+    RBCellRange range = grid_range(grid, render_pool.bounds[slot]);
+    render_pool.cells[slot] = range;
+
+    if (range.oversize)
+    {
+        grid_cell_add(&grid->oversize, slot);
+        return;
+    }
+
+    for (int cy = range.y0; cy <= range.y1; cy++)
+        for (int cx = range.x0; cx <= range.x1; cx++)
+            grid_cell_add(grid_cell(grid, cx, cy, true), slot);
+}
+
+static void grid_remove(RBSpatialGrid *grid, int slot)
+{
+    RBCellRange range = render_pool.cells[slot];
+    if (!range.inserted)
+        return;
+
+    render_pool.cells[slot].inserted = false;
+
+    if (range.oversize)
+    {
+        grid_cell_remove(&grid->oversize, slot);
+        return;
+    }
+
+    for (int cy = range.y0; cy <= range.y1; cy++)
+    {
+        for (int cx = range.x0; cx <= range.x1; cx++)
+        {
+            RBGridCell *cell = grid_cell(grid, cx, cy, false);
+            if (cell)
+                grid_cell_remove(cell, slot);
+        }
+    }
+}
+
+// recompute bounds of everything that changed since the last frame and refile it in its grid
+static void render_pool_flush_dirty(void)
+{
+    for (int i = 0; i < dirty_count; i++)
+    {
+        int slot = dirty_slots[i];
+        if (!render_pool.dirty[slot])
+            continue; // released since it was touched
+
+        render_pool.dirty[slot] = false;
+        render_pool.bounds[slot] = render_pool_compute_bounds(slot);
+
+        RBDrawList *owner = render_pool.owner[slot];
+        if (!owner || !owner->grid)
+            continue;
+
+        RBCellRange old_range = render_pool.cells[slot];
+        RBCellRange new_range = grid_range(owner->grid, render_pool.bounds[slot]);
+        if (old_range.inserted && old_range.x0 == new_range.x0 && old_range.y0 == new_range.y0 &&
+            old_range.x1 == new_range.x1 && old_range.y1 == new_range.y1)
+            continue;
+
+        grid_remove(owner->grid, slot);
+        grid_insert(owner->grid, slot);
+    }
+    dirty_count = 0;
+}
+
+static void render_props_mark(void *ptr)
+{
+    RBRenderProps *props = (RBRenderProps *)ptr;
+    rb_gc_mark(props->texture);
+}
+
+static void render_props_free(void *ptr)
+{
+    RBRenderProps *props = (RBRenderProps *)ptr;
+    render_pool_release(props->slot);
+    ruby_xfree(ptr);
+}
+
+static const rb_data_type_t render_props_type =
+    {
+        "RBScene::RenderObject",
+        {render_props_mark, render_props_free, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+static void draw_list_free(void *ptr)
+{
+    RBDrawList *list = (RBDrawList *)ptr;
+
+    // slots can outlive the list if their game object is still referenced elsewhere
+    for (int i = 0; i < list->count; i++)
+    {
+        if (list->slots[i] >= 0 && render_pool.owner[list->slots[i]] == list)
+            render_pool.owner[list->slots[i]] = NULL;
+    }
+
+    for (int i = 0; i < list->static_count; i++)
+        static_cache_unload(&list->statics[i]);
+    ruby_xfree(list->statics);
+    ruby_xfree(list->static_layers);
+    ruby_xfree(list->batch_layers);
+
+    if (list->grid)
+        grid_free(list->grid);
+    ruby_xfree(list->slots);
+    ruby_xfree(ptr);
+}
+
+static const rb_data_type_t draw_list_type =
+    {
+        "RBScene::DrawList",
+        {0, draw_list_free, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+static void collision_world_mark(void *ptr)
+{
+    RBCollisionWorld *world = (RBCollisionWorld *)ptr;
+    for (int i = 0; i < world->count; i++)
+        rb_gc_mark(world->objects[i]);
+    for (int i = 0; i < world->pair_count; i++)
+    {
+        rb_gc_mark(world->pairs[i].a);
+        rb_gc_mark(world->pairs[i].b);
+    }
+}
+
+static void collision_world_free(void *ptr)
+{
+    RBCollisionWorld *world = (RBCollisionWorld *)ptr;
+
+    for (int i = 0; i < world->count; i++)
+    {
+        int slot = world->slots[i];
+        if (render_pool.body_world[slot] == world)
+        {
+            render_pool.body[slot] = -1;
+            render_pool.body_world[slot] = NULL;
+        }
+    }
+
+    ruby_xfree(world->objects);
+    ruby_xfree(world->slots);
+    ruby_xfree(world->hitboxes);
+    ruby_xfree(world->aabbs);
+    ruby_xfree(world->callbacks);
+    ruby_xfree(world->order_pos);
+    ruby_xfree(world->order);
+    ruby_xfree(world->pairs);
+    ruby_xfree(ptr);
+}
+
+static const rb_data_type_t collision_world_type =
+    {
+        "RBScene::CollisionWorld",
+        {collision_world_mark, collision_world_free, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+static const rb_data_type_t rect_type =
+    {
+        "RBScene::Rect",
+        {0, RUBY_DEFAULT_FREE, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+static const rb_data_type_t vector2_type =
+    {
+        "RBScene::Vector2",
+        {0, RUBY_DEFAULT_FREE, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+static const rb_data_type_t camera_type =
+    {
+        "RBScene::Camera",
+        {0, RUBY_DEFAULT_FREE, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+static Rectangle *get_rect(VALUE self)
+{
+    Rectangle *rect;
+    TypedData_Get_Struct(self, Rectangle, &rect_type, rect);
+    return rect;
+}
+
+static Vector2 *get_vector2(VALUE self)
+{
+    Vector2 *vec;
+    TypedData_Get_Struct(self, Vector2, &vector2_type, vec);
+    return vec;
+}
+
+// accepts a Vector2 or a two element Array, eg. rect.center = [10, 20]
+static Vector2 vector2_value(VALUE val)
+{
+    if (rb_obj_is_kind_of(val, vector2_class))
+        return *get_vector2(val);
+
+    if (RB_TYPE_P(val, T_ARRAY) && RARRAY_LEN(val) == 2)
+        return (Vector2){NUM2DBL(RARRAY_AREF(val, 0)), NUM2DBL(RARRAY_AREF(val, 1))};
+
+    VALUE class_name = rb_class_name(rb_obj_class(val));
+    rb_raise(rb_eTypeError, "Expected a Vector2 or [x, y], got %s", StringValueCStr(class_name));
+    return (Vector2){0}; // unreachable
+}
+
+static VALUE vector2_new(Vector2 value)
+{
+    Vector2 *vec;
+    VALUE vec_val = TypedData_Make_Struct(vector2_class, Vector2, &vector2_type, vec);
+    *vec = value;
+    return vec_val;
+}
+
+// writes into out when one is given instead of allocating, for accessors called every frame
+static VALUE vector2_out(int argc, VALUE *argv, Vector2 value)
+{
+    VALUE out;
+    rb_scan_args(argc, argv, "01", &out);
+    if (NIL_P(out))
+        return vector2_new(value);
+
+    *get_vector2(out) = value;
+    return out;
+}
+
+static VALUE vector2_alloc(VALUE self)
+{
+    Vector2 *vec;
+    return TypedData_Make_Struct(self, Vector2, &vector2_type, vec);
+}
+
+static VALUE vector2_initialize(int argc, VALUE *argv, VALUE self)
+{
+    VALUE x, y;
+    rb_scan_args(argc, argv, "02", &x, &y);
+
+    Vector2 *vec = get_vector2(self);
+    vec->x = NIL_P(x) ? 0 : NUM2DBL(x);
+    vec->y = NIL_P(y) ? 0 : NUM2DBL(y);
+    return self;
+}
+
+static VALUE vector2_initialize_copy(VALUE self, VALUE other)
+{
+    *get_vector2(self) = *get_vector2(other);
+    return self;
+}
+
+static VALUE vector2_x_getter(VALUE self)
+{
+    return DBL2NUM(get_vector2(self)->x);
+}
+
+static VALUE vector2_x_setter(VALUE self, VALUE val)
+{
+    get_vector2(self)->x = NUM2DBL(val);
+    return val;
+}
+
+static VALUE vector2_y_getter(VALUE self)
+{
+    return DBL2NUM(get_vector2(self)->y);
+}
+
+static VALUE vector2_y_setter(VALUE self, VALUE val)
+{
+    get_vector2(self)->y = NUM2DBL(val);
+    return val;
+}
+
+static VALUE vector2_set(VALUE self, VALUE x, VALUE y)
+{
+    Vector2 *vec = get_vector2(self);
+    vec->x = NUM2DBL(x);
+    vec->y = NUM2DBL(y);
+    return self;
+}
+
+// operators return a new Vector2, the bang methods below change the receiver instead
+
+static VALUE vector2_add(VALUE self, VALUE other)
+{
+    Vector2 a = *get_vector2(self), b = vector2_value(other);
+    return vector2_new((Vector2){a.x + b.x, a.y + b.y});
+}
+
+static VALUE vector2_sub(VALUE self, VALUE other)
+{
+    Vector2 a = *get_vector2(self), b = vector2_value(other);
+    return vector2_new((Vector2){a.x - b.x, a.y - b.y});
+}
+
+static VALUE vector2_mul(VALUE self, VALUE scalar)
+{
+    Vector2 a = *get_vector2(self);
+    float s = NUM2DBL(scalar);
+    return vector2_new((Vector2){a.x * s, a.y * s});
+}
+
+static VALUE vector2_div(VALUE self, VALUE scalar)
+{
+    Vector2 a = *get_vector2(self);
+    float s = NUM2DBL(scalar);
+    return vector2_new((Vector2){a.x / s, a.y / s});
+}
+
+static VALUE vector2_neg(VALUE self)
+{
+    Vector2 a = *get_vector2(self);
+    return vector2_new((Vector2){-a.x, -a.y});
+}
+
+static VALUE vector2_eq(VALUE self, VALUE other)
+{
+    if (!rb_obj_is_kind_of(other, vector2_class))
+        return Qfalse;
+    Vector2 a = *get_vector2(self), b = *get_vector2(other);
+    return a.x == b.x && a.y == b.y ? Qtrue : Qfalse;
+}
+
+static VALUE vector2_add_bang(VALUE self, VALUE other)
+{
+    Vector2 *a = get_vector2(self);
+    Vector2 b = vector2_value(other);
+    a->x += b.x;
+    a->y += b.y;
+    return self;
+}
+
+static VALUE vector2_sub_bang(VALUE self, VALUE other)
+{
+    Vector2 *a = get_vector2(self);
+    Vector2 b = vector2_value(other);
+    a->x -= b.x;
+    a->y -= b.y;
+    return self;
+}
+
+static VALUE vector2_scale_bang(VALUE self, VALUE scalar)
+{
+    Vector2 *a = get_vector2(self);
+    float s = NUM2DBL(scalar);
+    a->x *= s;
+    a->y *= s;
+    return self;
+}
+
+// zero vectors stay zero
+static VALUE vector2_normalize_bang(VALUE self)
+{
+    Vector2 *a = get_vector2(self);
+    float length = sqrtf(a->x * a->x + a->y * a->y);
+    if (length > 0)
+    {
+        a->x /= length;
+        a->y /= length;
+    }
+    return self;
+}
+
+static VALUE vector2_normalize(VALUE self)
+{
+    return vector2_normalize_bang(vector2_new(*get_vector2(self)));
+}
+
+static VALUE vector2_lerp_bang(VALUE self, VALUE other, VALUE t_val)
+{
+    Vector2 *a = get_vector2(self);
+    Vector2 b = vector2_value(other);
+    float t = NUM2DBL(t_val);
+    a->x += (b.x - a->x) * t;
+    a->y += (b.y - a->y) * t;
+    return self;
+}
+
+static VALUE vector2_lerp(VALUE self, VALUE other, VALUE t_val)
+{
+    return vector2_lerp_bang(vector2_new(*get_vector2(self)), other, t_val);
+}
+
+static VALUE vector2_length(VALUE self)
+{
+    Vector2 a = *get_vector2(self);
+    return DBL2NUM(sqrtf(a.x * a.x + a.y * a.y));
+}
+
+static VALUE vector2_dot(VALUE self, VALUE other)
+{
+    Vector2 a = *get_vector2(self), b = vector2_value(other);
+    return DBL2NUM(a.x * b.x + a.y * b.y);
+}
+
+static VALUE vector2_distance_to(VALUE self, VALUE other)
+{
+    Vector2 a = *get_vector2(self), b = vector2_value(other);
+    return DBL2NUM(hypotf(b.x - a.x, b.y - a.y));
+}
+
+// global engine variables
+static Camera2D *cam = NULL;
+
+// input codes share one space, keyboard keys are raylib keycodes and gamepad inputs sit above them
+// axes are split into a negative and positive direction so a stick can be bound like a button
+#define INPUT_KEY_COUNT 512
+#define INPUT_GAMEPAD_BUTTON_BASE INPUT_KEY_COUNT
+#define INPUT_GAMEPAD_BUTTON_COUNT 32
+#define INPUT_GAMEPAD_AXIS_BASE (INPUT_GAMEPAD_BUTTON_BASE + INPUT_GAMEPAD_BUTTON_COUNT)
+#define INPUT_GAMEPAD_AXIS_COUNT 8
+#define INPUT_CODE_COUNT (INPUT_GAMEPAD_AXIS_BASE + INPUT_GAMEPAD_AXIS_COUNT * 2)
+#define INPUT_WORDS ((INPUT_CODE_COUNT + 63) / 64)
+#define INPUT_AXIS_THRESHOLD 0.5f
+
+#define INPUT_BUTTON(button) (INPUT_GAMEPAD_BUTTON_BASE + (button))
+#define INPUT_AXIS(axis, positive) (INPUT_GAMEPAD_AXIS_BASE + (axis) * 2 + (positive))
+
+typedef struct
+{
+    const char *name;
+    int code;
+} RBInputName;
+
+static const RBInputName input_names[] = {
+    {"space", KEY_SPACE},
+    {"enter", KEY_ENTER},
+    {"escape", KEY_ESCAPE},
+    {"tab", KEY_TAB},
+    {"backspace", KEY_BACKSPACE},
+    {"insert", KEY_INSERT},
+    {"delete", KEY_DELETE},
+    {"left", KEY_LEFT},
+    {"right", KEY_RIGHT},
+    {"up", KEY_UP},
+    {"down", KEY_DOWN},
+    {"page_up", KEY_PAGE_UP},
+    {"page_down", KEY_PAGE_DOWN},
+    {"home", KEY_HOME},
+    {"end", KEY_END},
+    {"left_shift", KEY_LEFT_SHIFT},
+    {"right_shift", KEY_RIGHT_SHIFT},
+    {"left_control", KEY_LEFT_CONTROL},
+    {"right_control", KEY_RIGHT_CONTROL},
+    {"left_alt", KEY_LEFT_ALT},
+    {"right_alt", KEY_RIGHT_ALT},
+    {"apostrophe", KEY_APOSTROPHE},
+    {"comma", KEY_COMMA},
+    {"minus", KEY_MINUS},
+    {"period", KEY_PERIOD},
+    {"slash", KEY_SLASH},
+    {"semicolon", KEY_SEMICOLON},
+    {"equal", KEY_EQUAL},
+    {"gp_up", INPUT_BUTTON(GAMEPAD_BUTTON_LEFT_FACE_UP)},
+    {"gp_right", INPUT_BUTTON(GAMEPAD_BUTTON_LEFT_FACE_RIGHT)},
+    {"gp_down", INPUT_BUTTON(GAMEPAD_BUTTON_LEFT_FACE_DOWN)},
+    {"gp_left", INPUT_BUTTON(GAMEPAD_BUTTON_LEFT_FACE_LEFT)},
+    {"gp_y", INPUT_BUTTON(GAMEPAD_BUTTON_RIGHT_FACE_UP)},
+    {"gp_b", INPUT_BUTTON(GAMEPAD_BUTTON_RIGHT_FACE_RIGHT)},
+    {"gp_a", INPUT_BUTTON(GAMEPAD_BUTTON_RIGHT_FACE_DOWN)},
+    {"gp_x", INPUT_BUTTON(GAMEPAD_BUTTON_RIGHT_FACE_LEFT)},
+    {"gp_lb", INPUT_BUTTON(GAMEPAD_BUTTON_LEFT_TRIGGER_1)},
+    {"gp_lt", INPUT_BUTTON(GAMEPAD_BUTTON_LEFT_TRIGGER_2)},
+    {"gp_rb", INPUT_BUTTON(GAMEPAD_BUTTON_RIGHT_TRIGGER_1)},
+    {"gp_rt", INPUT_BUTTON(GAMEPAD_BUTTON_RIGHT_TRIGGER_2)},
+    {"gp_select", INPUT_BUTTON(GAMEPAD_BUTTON_MIDDLE_LEFT)},
+    {"gp_home", INPUT_BUTTON(GAMEPAD_BUTTON_MIDDLE)},
+    {"gp_start", INPUT_BUTTON(GAMEPAD_BUTTON_MIDDLE_RIGHT)},
+    {"gp_l3", INPUT_BUTTON(GAMEPAD_BUTTON_LEFT_THUMB)},
+    {"gp_r3", INPUT_BUTTON(GAMEPAD_BUTTON_RIGHT_THUMB)},
+    {"gp_left_stick_left", INPUT_AXIS(GAMEPAD_AXIS_LEFT_X, 0)},
+    {"gp_left_stick_right", INPUT_AXIS(GAMEPAD_AXIS_LEFT_X, 1)},
+    {"gp_left_stick_up", INPUT_AXIS(GAMEPAD_AXIS_LEFT_Y, 0)},
+    {"gp_left_stick_down", INPUT_AXIS(GAMEPAD_AXIS_LEFT_Y, 1)},
+    {"gp_right_stick_left", INPUT_AXIS(GAMEPAD_AXIS_RIGHT_X, 0)},
+    {"gp_right_stick_right", INPUT_AXIS(GAMEPAD_AXIS_RIGHT_X, 1)},
+    {"gp_right_stick_up", INPUT_AXIS(GAMEPAD_AXIS_RIGHT_Y, 0)},
+    {"gp_right_stick_down", INPUT_AXIS(GAMEPAD_AXIS_RIGHT_Y, 1)},
+};
+
+// analog axes by name for Input.axis, values are -1 to 1
+static const RBInputName input_axis_names[] = {
+    {"gp_left_x", GAMEPAD_AXIS_LEFT_X},
+    {"gp_left_y", GAMEPAD_AXIS_LEFT_Y},
+    {"gp_right_x", GAMEPAD_AXIS_RIGHT_X},
+    {"gp_right_y", GAMEPAD_AXIS_RIGHT_Y},
+    {"gp_left_trigger", GAMEPAD_AXIS_LEFT_TRIGGER},
+    {"gp_right_trigger", GAMEPAD_AXIS_RIGHT_TRIGGER},
+};
+
+// only called when an input is defined, never per frame
+static int symbol_to_keycode(VALUE sym)
+{
+    Check_Type(sym, T_SYMBOL);
+    const char *name = rb_id2name(SYM2ID(sym));
+
+    for (size_t i = 0; i < sizeof(input_names) / sizeof(input_names[0]); i++)
+    {
+        if (strcmp(name, input_names[i].name) == 0)
+            return input_names[i].code;
+    }
+
+    // a-z and 0-9 keys
+    if (strlen(name) == 1 && name[0] >= 'a' && name[0] <= 'z')
+    {
+        return KEY_A + (name[0] - 'a');
+    }
+    if (strlen(name) == 1 && name[0] >= '0' && name[0] <= '9')
+    {
+        return KEY_ZERO + (name[0] - '0');
+    }
+
+    // f1-f12, the rest of the name has to be the number and nothing else
+    size_t digits = strspn(name + 1, "0123456789");
+    if (name[0] == 'f' && name[1] >= '1' && name[1] <= '9' && digits <= 2 && name[1 + digits] == '\0')
+    {
+        int n = atoi(name + 1);
+        if (n >= 1 && n <= 12)
+            return KEY_F1 + n - 1;
+    }
+
+    rb_raise(rb_eArgError, "Unrecognized key symbol: :%s", name);
+    return -1; // unreachable, but needed for compilation
+}
+
+// one binding per Input.define, query methods find theirs by method name
+typedef struct
+{
+    int *codes;
+    int count;
+} RBInputBinding;
+
+enum
+{
+    INPUT_QUERY_DOWN,
+    INPUT_QUERY_PRESS,
+    INPUT_QUERY_RELEASE
+};
+
+static RBInputBinding *input_bindings = NULL;
+static int input_binding_count = 0;
+static int input_binding_capacity = 0;
+
+// input name ID -> binding index, query method ID -> binding index * 3 + query
+static st_table *input_binding_index = NULL;
+static st_table *input_query_index = NULL;
+
+// every code used by some binding, these are the only ones polled each frame
+static int *input_polled = NULL;
+static int input_polled_count = 0;
+
+static uint64_t input_down[INPUT_WORDS];
+static uint64_t input_prev[INPUT_WORDS];
+
+static inline bool input_bit(const uint64_t *bits, int code)
+{
+    return (bits[code >> 6] >> (code & 63)) & 1;
+}
+
+static void input_rebuild_polled(void)
+{
+    uint64_t seen[INPUT_WORDS] = {0};
+    input_polled_count = 0;
+    REALLOC_N(input_polled, int, INPUT_CODE_COUNT);
+
+    for (int i = 0; i < input_binding_count; i++)
+    {
+        RBInputBinding *binding = &input_bindings[i];
+        for (int j = 0; j < binding->count; j++)
+        {
+            int code = binding->codes[j];
+            if (input_bit(seen, code))
+                continue;
+            seen[code >> 6] |= 1ULL << (code & 63);
+            input_polled[input_polled_count++] = code;
+        }
+    }
+
+    // codes no binding uses anymore stop being polled, so their last state would never clear
+    for (int w = 0; w < INPUT_WORDS; w++)
+    {
+        input_down[w] &= seen[w];
+        input_prev[w] &= seen[w];
+    }
+}
+
+static bool input_poll_code(int code, bool gamepad)
+{
+    if (code < INPUT_KEY_COUNT)
+        return IsKeyDown(code);
+
+    if (!gamepad)
+        return false;
+
+    if (code < INPUT_GAMEPAD_AXIS_BASE)
+        return IsGamepadButtonDown(0, code - INPUT_GAMEPAD_BUTTON_BASE);
+
+    int axis = (code - INPUT_GAMEPAD_AXIS_BASE) / 2;
+    float value = GetGamepadAxisMovement(0, axis);
+    return (code - INPUT_GAMEPAD_AXIS_BASE) % 2 ? value > INPUT_AXIS_THRESHOLD : value < -INPUT_AXIS_THRESHOLD;
+}
+
+// called once per frame, presses and releases are edges against the state at the end of the last update step
+// so a frame that runs several steps only reports each edge in the first
+static void input_poll(void)
+{
+    if (headless)
+    {
+        memset(input_down, 0, sizeof(input_down));
+        return;
+    }
+
+    bool gamepad = IsGamepadAvailable(0);
+    for (int i = 0; i < input_polled_count; i++)
+    {
+        int code = input_polled[i];
+        uint64_t mask = 1ULL << (code & 63);
+        if (input_poll_code(code, gamepad))
+            input_down[code >> 6] |= mask;
+        else
+            input_down[code >> 6] &= ~mask;
+    }
+}
+
+static void input_end_step(void)
+{
+    memcpy(input_prev, input_down, sizeof(input_down));
+}
+
+// shared body of every generated query method, eg. Input.up, Input.up_press and Input.up_release
+static VALUE input_query(VALUE self)
+{
+    st_data_t entry;
+    if (!st_lookup(input_query_index, (st_data_t)rb_frame_callee(), &entry))
+        rb_raise(rb_eNameError, "Input query is not bound to a defined input");
+
+    RBInputBinding *binding = &input_bindings[entry / 3];
+    int query = entry % 3;
+
+    for (int i = 0; i < binding->count; i++)
+    {
+        int code = binding->codes[i];
+        bool down = input_bit(input_down, code);
+        bool was_down = input_bit(input_prev, code);
+
+        if ((query == INPUT_QUERY_DOWN && down) ||
+            (query == INPUT_QUERY_PRESS && down && !was_down) ||
+            (query == INPUT_QUERY_RELEASE && !down && was_down))
+            return Qtrue;
+    }
+    return Qfalse;
+}
+
+static VALUE input_bind(VALUE self, VALUE name, VALUE codes)
+{
+    Check_Type(codes, T_ARRAY);
+    ID name_id = rb_to_id(name);
+
+    if (!input_binding_index)
+    {
+        input_binding_index = st_init_numtable();
+        input_query_index = st_init_numtable();
+    }
+
+    st_data_t index;
+    if (!st_lookup(input_binding_index, (st_data_t)name_id, &index))
+    {
+        if (input_binding_count == input_binding_capacity)
+        {
+            input_binding_capacity = input_binding_capacity ? input_binding_capacity * 2 : 16;
+            REALLOC_N(input_bindings, RBInputBinding, input_binding_capacity);
+        }
+        index = input_binding_count++;
+        input_bindings[index] = (RBInputBinding){0};
+        st_insert(input_binding_index, (st_data_t)name_id, index);
+    }
+
+    // resolve every symbol before touching the binding, so a bad key leaves the old one intact
+    int count = (int)RARRAY_LEN(codes);
+    int *resolved = ALLOC_N(int, count ? count : 1);
+    for (int i = 0; i < count; i++)
+    {
+        int code = symbol_to_keycode(RARRAY_AREF(codes, i));
+        if (code < 0 || code >= INPUT_CODE_COUNT)
+        {
+            xfree(resolved);
+            rb_raise(rb_eArgError, "Input code out of range: %d", code);
+        }
+        resolved[i] = code;
+    }
+
+    RBInputBinding *binding = &input_bindings[index];
+    xfree(binding->codes);
+    binding->codes = resolved;
+    binding->count = count;
+    input_rebuild_polled();
+
+    // the three query methods are all input_query, it tells them apart by the name it was called as
+    const char *suffixes[3] = {"", "_press", "_release"};
+    for (int query = INPUT_QUERY_DOWN; query <= INPUT_QUERY_RELEASE; query++)
+    {
+        VALUE method_name = rb_sprintf("%s%s", rb_id2name(name_id), suffixes[query]);
+        st_insert(input_query_index, (st_data_t)rb_intern_str(method_name), index * 3 + query);
+        rb_define_singleton_method(self, StringValueCStr(method_name), input_query, 0);
+    }
+
+    return Qnil;
+}
+
+// the binding keeps its index so its query method IDs stay valid if the name is defined again
+static VALUE input_unbind(VALUE self, VALUE name)
+{
+    st_data_t index;
+    if (!input_binding_index || !st_lookup(input_binding_index, (st_data_t)rb_to_id(name), &index))
+        return Qnil;
+
+    RBInputBinding *binding = &input_bindings[index];
+    xfree(binding->codes);
+    binding->codes = NULL;
+    binding->count = 0;
+    input_rebuild_polled();
+    return Qnil;
+}
+
+static VALUE input_axis(VALUE self, VALUE sym)
+{
+    Check_Type(sym, T_SYMBOL);
+    const char *name = rb_id2name(SYM2ID(sym));
+
+    for (size_t i = 0; i < sizeof(input_axis_names) / sizeof(input_axis_names[0]); i++)
+    {
+        if (strcmp(name, input_axis_names[i].name) == 0)
+        {
+            if (headless || !IsGamepadAvailable(0))
+                return DBL2NUM(0.0);
+            return DBL2NUM(GetGamepadAxisMovement(0, input_axis_names[i].code));
+        }
+    }
+
+    rb_raise(rb_eArgError, "Unrecognized axis symbol: :%s", name);
+    return Qnil;
+}
+
+static RBEngineConfig get_engine_config()
+{
+    VALUE config_val = rb_iv_get(engine_class, "@config");
+
+    VALUE window_title_val = rb_iv_get(config_val, "@window_title");
+    Check_Type(window_title_val, T_STRING);
+
+    VALUE window_size_val = rb_iv_get(config_val, "@window_size");
+    Check_Type(window_size_val, T_ARRAY);
+
+    VALUE window_width_val = rb_ary_entry(window_size_val, 0);
+    VALUE window_height_val = rb_ary_entry(window_size_val, 1);
+
+    if (!rb_obj_is_kind_of(window_width_val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "Window width is not a Numeric");
+
+    if (!rb_obj_is_kind_of(window_height_val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "Window height is not a Numeric");
+
+    VALUE asset_upload_budget_val = rb_iv_get(config_val, "@asset_upload_budget");
+    if (!rb_obj_is_kind_of(asset_upload_budget_val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "Asset upload budget is not a Numeric");
+
+    RBEngineConfig config;
+    config.window_title = StringValueCStr(window_title_val);
+    config.window_width = NUM2UINT(window_width_val);
+    config.window_height = NUM2UINT(window_height_val);
+    config.asset_upload_budget = NUM2DBL(asset_upload_budget_val) / 1000.0;
+
+    config.headless = RTEST(rb_iv_get(config_val, "@headless"));
+    config.record_frame_times = RTEST(rb_iv_get(config_val, "@record_frame_times"));
+
+    VALUE max_frames_val = rb_iv_get(config_val, "@max_frames");
+    config.max_frames = NIL_P(max_frames_val) ? 0 : NUM2LONG(max_frames_val);
+
+    config.fixed_dt = NUM2DBL(rb_iv_get(config_val, "@fixed_dt"));
+    if (config.fixed_dt <= 0)
+        rb_raise(rb_eArgError, "fixed_dt must be greater than 0");
+
+    config.max_substeps = NUM2INT(rb_iv_get(config_val, "@max_substeps"));
+    if (config.max_substeps < 1)
+        rb_raise(rb_eArgError, "max_substeps must be at least 1");
+
+    config.target_fps = NUM2INT(rb_iv_get(config_val, "@target_fps"));
+    config.interpolate = RTEST(rb_iv_get(config_val, "@interpolate"));
+
+    VALUE gc_mode_val = rb_iv_get(config_val, "@gc_mode");
+    if (gc_mode_val == ID2SYM(rb_intern("ruby")))
+        config.gc_mode = GC_MODE_RUBY;
+    else if (gc_mode_val == ID2SYM(rb_intern("frame")))
+        config.gc_mode = GC_MODE_FRAME;
+    else
+        rb_raise(rb_eArgError, "gc_mode must be :ruby or :frame");
+
+    config.gc_on_scene_switch = RTEST(rb_iv_get(config_val, "@gc_on_scene_switch"));
+    config.gc_max_skipped_frames = NUM2INT(rb_iv_get(config_val, "@gc_max_skipped_frames"));
+
+    VALUE asset_budget_val = rb_iv_get(config_val, "@asset_budget");
+    config.asset_budget = NIL_P(asset_budget_val) ? SIZE_MAX : (size_t)(NUM2DBL(asset_budget_val) * 1024 * 1024);
+
+    return config;
+}
+
+static VALUE engine_init(VALUE self)
+{
+    RBEngineConfig config = get_engine_config();
+
+    window_width = config.window_width;
+    window_height = config.window_height;
+    asset_budget = config.asset_budget;
+
+    // headless runs the same pipeline with no window or audio device, frames are not capped
+    headless = config.headless;
+    if (headless)
+        return Qnil;
+
+    InitWindow(config.window_width, config.window_height, config.window_title);
+    InitAudioDevice();
+    SetAudioStreamBufferSizeDefault(MUSIC_BUFFER_FRAMES);
+    SetTargetFPS(config.target_fps);
+
+    return Qnil;
+}
+
+static VALUE engine_update(VALUE self)
+{
+    RBEngineConfig config = get_engine_config();
+
+    window_width = config.window_width;
+    window_height = config.window_height;
+    asset_budget = config.asset_budget;
+    asset_trim(asset_budget);
+
+    if (headless)
+        return Qnil;
+
+    SetWindowTitle(config.window_title);
+    SetWindowSize(config.window_width, config.window_height);
+    SetTargetFPS(config.target_fps);
+
+    return Qnil;
+}
+
+static VALUE engine_stop(VALUE self)
+{
+    stop_requested = true;
+    return Qnil;
+}
+
+static VALUE engine_frame_count(VALUE self)
+{
+    return LONG2NUM(frame_count);
+}
+
+static VALUE engine_step_count(VALUE self)
+{
+    return LONG2NUM(step_count);
+}
+
+static VALUE engine_stepping_p(VALUE self)
+{
+    return engine_stepping ? Qtrue : Qfalse;
+}
+
+// durations in seconds of every frame of the last run, only recorded when the config asks for it
+static VALUE engine_frame_times(VALUE self)
+{
+    VALUE times = rb_ary_new_capa(frame_log_count);
+    for (long i = 0; i < frame_log_count; i++)
+        rb_ary_push(times, DBL2NUM(frame_log[i].seconds));
+    return times;
+}
+
+// GC.count at the end of every recorded frame
+static VALUE engine_frame_gc_counts(VALUE self)
+{
+    VALUE counts = rb_ary_new_capa(frame_log_count);
+    for (long i = 0; i < frame_log_count; i++)
+        rb_ary_push(counts, SIZET2NUM(frame_log[i].gc_count));
+    return counts;
+}
+
+static void frame_log_push(double seconds)
+{
+    if (frame_log_count == frame_log_capacity)
+    {
+        frame_log_capacity = frame_log_capacity ? frame_log_capacity * 2 : 1024;
+        REALLOC_N(frame_log, RBFrameLogEntry, frame_log_capacity);
+    }
+    frame_log[frame_log_count++] = (RBFrameLogEntry){.seconds = seconds, .gc_count = rb_gc_count()};
+}
+
+// gc scheduling and telemetry, totals cover the current Engine.run
+typedef struct
+{
+    int mode;
+    long frames;
+    double time_ms;
+    double max_frame_ms;
+    long allocated;
+    long max_frame_allocated;
+    long minor, major;     // collections of each kind, whoever started them
+    long scheduled_minor;  // run by the engine in time left over at the end of a frame
+    long scheduled_major;
+    long forced;           // run by the engine after gc_max_skipped_frames frames without time for one
+    long scene_switches;   // full collections after a scene switch
+    double last_frame_ms;
+    long last_frame_allocated;
+} RBGCStats;
+
+static RBGCStats gc_stats;
+static bool gc_frame_mode = false;
+static int gc_skipped_frames = 0;
+static size_t gc_allocated_at_last_run = 0;
+static size_t gc_frame_allocated_start, gc_frame_minor_start, gc_frame_major_start;
+
+// GC.stat(:time) only counts whole milliseconds, so GC time is measured from the GC's own enter and exit events
+static VALUE gc_tracepoint = Qnil;
+static double gc_entered_at = 0;
+static double gc_frame_seconds = 0;
+
+// running estimates of how long each kind of collection takes, in seconds
+static double gc_minor_estimate = 0.001;
+static double gc_major_estimate = 0.01;
+
+static size_t gc_stat(const char *key)
+{
+    return rb_gc_stat(ID2SYM(rb_intern(key)));
+}
+
+static void gc_event(VALUE tpval, void *data)
+{
+    rb_trace_arg_t *arg = rb_tracearg_from_tracepoint(tpval);
+    if (rb_tracearg_event_flag(arg) == RUBY_INTERNAL_EVENT_GC_ENTER)
+        gc_entered_at = now_seconds();
+    else
+        gc_frame_seconds += now_seconds() - gc_entered_at;
+}
+
+static void gc_begin_run(RBEngineConfig *config)
+{
+    if (NIL_P(gc_tracepoint))
+    {
+        gc_tracepoint = rb_tracepoint_new(0, RUBY_INTERNAL_EVENT_GC_ENTER | RUBY_INTERNAL_EVENT_GC_EXIT, gc_event, NULL);
+        rb_gc_register_mark_object(gc_tracepoint);
+    }
+    rb_tracepoint_enable(gc_tracepoint);
+
+    memset(&gc_stats, 0, sizeof(gc_stats));
+    gc_stats.mode = config->gc_mode;
+    gc_skipped_frames = 0;
+    gc_frame_mode = config->gc_mode == GC_MODE_FRAME;
+    gc_allocated_at_last_run = gc_stat("total_allocated_objects");
+}
+
+static void gc_end_run(void)
+{
+    if (!NIL_P(gc_tracepoint))
+        rb_tracepoint_disable(gc_tracepoint);
+    if (gc_frame_mode)
+        rb_gc_enable();
+    gc_frame_mode = false;
+}
+
+// frame mode turns GC off only from here to gc_end_frame, Ruby can still collect on its own outside that
+// turning it off finishes any sweep a minor collection left, so that work lands here at worst
+static void gc_begin_frame(void)
+{
+    if (gc_frame_mode)
+        rb_gc_disable();
+    gc_frame_seconds = 0;
+    gc_frame_allocated_start = gc_stat("total_allocated_objects");
+    gc_frame_minor_start = gc_stat("minor_gc_count");
+    gc_frame_major_start = gc_stat("major_gc_count");
+}
+
+// minor collections sweep lazily, so only the marking has to fit in the frame
+static void gc_collect(bool full)
+{
+    double start = now_seconds();
+
+    VALUE opts = rb_hash_new();
+    rb_hash_aset(opts, ID2SYM(rb_intern("full_mark")), full ? Qtrue : Qfalse);
+    rb_hash_aset(opts, ID2SYM(rb_intern("immediate_sweep")), full ? Qtrue : Qfalse);
+    rb_funcallv_kw(rb_mGC, rb_intern("start"), 1, &opts, RB_PASS_KEYWORDS);
+
+    double seconds = now_seconds() - start;
+    double *estimate = full ? &gc_major_estimate : &gc_minor_estimate;
+    *estimate = *estimate * 0.8 + seconds * 0.2;
+
+    gc_skipped_frames = 0;
+    gc_allocated_at_last_run = gc_stat("total_allocated_objects");
+}
+
+// runs before present, so the collection fills time that would otherwise be spent waiting for the frame cap
+static void gc_end_frame(RBEngineConfig *config, double frame_start, bool scene_switched)
+{
+    // GC.start does nothing while GC is disabled, and it stays on until the next frame begins
+    if (gc_frame_mode)
+        rb_gc_enable();
+
+    // a quarter of the heap's slots allocated since the last collection is roughly when Ruby would run a minor one
+    size_t since_last_run = gc_stat("total_allocated_objects") - gc_allocated_at_last_run;
+    if (scene_switched && config->gc_on_scene_switch)
+    {
+        gc_collect(true);
+        gc_stats.scene_switches++;
+    }
+    else if (gc_frame_mode && since_last_run >= gc_stat("heap_available_slots") / 4)
+    {
+        double budget = config->target_fps > 0 ? 1.0 / config->target_fps : config->fixed_dt;
+        double remaining = budget - (now_seconds() - frame_start);
+        bool need_major = !NIL_P(rb_gc_latest_gc_info(ID2SYM(rb_intern("need_major_by"))));
+
+        if (need_major && remaining > gc_major_estimate)
+        {
+            gc_collect(true);
+            gc_stats.scheduled_major++;
+        }
+        else if (remaining > gc_minor_estimate)
+        {
+            gc_collect(false);
+            gc_stats.scheduled_minor++;
+        }
+        else if (++gc_skipped_frames >= config->gc_max_skipped_frames)
+        {
+            // the heap only grows while GC is off, so it can't be put off forever
+            gc_collect(need_major);
+            gc_stats.forced++;
+        }
+    }
+
+    double ms = gc_frame_seconds * 1000.0;
+    long allocated = (long)(gc_stat("total_allocated_objects") - gc_frame_allocated_start);
+
+    gc_stats.frames++;
+    gc_stats.time_ms += ms;
+    gc_stats.allocated += allocated;
+    gc_stats.minor += gc_stat("minor_gc_count") - gc_frame_minor_start;
+    gc_stats.major += gc_stat("major_gc_count") - gc_frame_major_start;
+    if (ms > gc_stats.max_frame_ms)
+        gc_stats.max_frame_ms = ms;
+    if (allocated > gc_stats.max_frame_allocated)
+        gc_stats.max_frame_allocated = allocated;
+    gc_stats.last_frame_ms = ms;
+    gc_stats.last_frame_allocated = allocated;
+
+    if (profile_current)
+    {
+        profile_current->gc_ms = ms;
+        profile_current->allocated = allocated;
+    }
+}
+
+static bool engine_should_stop(RBEngineConfig *config)
+{
+    if (stop_requested)
+        return true;
+    if (config->max_frames > 0 && frame_count >= config->max_frames)
+        return true;
+    return !headless && WindowShouldClose();
+}
+
+// tickers, every TickerManager's tickers live in one engine owned pool advanced once per update step
+// a ticker counts steps up to its rate, then steps its value, wrapping at limit
+
+typedef struct
+{
+    int next_free; // -1 while in use
+    bool running;
+    int rate;
+    int limit;
+    int value;
+    int counter;
+    unsigned int generation; // bumped whenever the slot gets a new ticker, so stale completions can be told apart
+    VALUE on_complete;       // called each time value wraps back to 0, nil for none
+} RBTicker;
+
+typedef struct
+{
+    int slot;
+    unsigned int generation;
+} RBTickerCompletion;
+
+static RBTicker *ticker_pool = NULL;
+static int ticker_pool_count = 0; // slots handed out so far, live or free
+static int ticker_pool_capacity = 0;
+static int ticker_pool_free = -1;
+
+// slots whose ticker wrapped this frame, callbacks run after the pass so they can add or remove tickers
+static RBTickerCompletion *ticker_completed = NULL;
+static int ticker_completed_count = 0;
+static int ticker_completed_capacity = 0;
+
+typedef struct
+{
+    st_table *slots; // name ID -> pool slot
+} RBTickerManager;
+
+static int ticker_pool_alloc(void)
+{
+    int slot;
+    unsigned int generation = 0;
+    if (ticker_pool_free >= 0)
+    {
+        slot = ticker_pool_free;
+        ticker_pool_free = ticker_pool[slot].next_free;
+        generation = ticker_pool[slot].generation + 1;
+    }
+    else
+    {
+        if (ticker_pool_count == ticker_pool_capacity)
+        {
+            ticker_pool_capacity = ticker_pool_capacity ? ticker_pool_capacity * 2 : 256;
+            REALLOC_N(ticker_pool, RBTicker, ticker_pool_capacity);
+        }
+        slot = ticker_pool_count++;
+    }
+
+    ticker_pool[slot] = (RBTicker){.next_free = -1, .generation = generation, .on_complete = Qnil};
+    return slot;
+}
+
+static void ticker_pool_release(int slot)
+{
+    unsigned int generation = ticker_pool[slot].generation;
+    ticker_pool[slot] = (RBTicker){.next_free = ticker_pool_free, .generation = generation, .on_complete = Qnil};
+    ticker_pool_free = slot;
+}
+
+static void ticker_pool_advance(void)
+{
+    ticker_completed_count = 0;
+
+    for (int slot = 0; slot < ticker_pool_count; slot++)
+    {
+        RBTicker *t = &ticker_pool[slot];
+        if (!t->running)
+            continue;
+
+        t->counter += 1;
+        if (t->counter <= t->rate)
+            continue;
+
+        t->value += 1;
+        t->counter = 0;
+        if (t->value >= t->limit)
+        {
+            t->value = 0;
+            if (!NIL_P(t->on_complete))
+            {
+                if (ticker_completed_count == ticker_completed_capacity)
+                {
+                    ticker_completed_capacity = ticker_completed_capacity ? ticker_completed_capacity * 2 : 64;
+                    REALLOC_N(ticker_completed, RBTickerCompletion, ticker_completed_capacity);
+                }
+                ticker_completed[ticker_completed_count++] = (RBTickerCompletion){slot, t->generation};
+            }
+        }
+    }
+
+    for (int i = 0; i < ticker_completed_count; i++)
+    {
+        // an earlier callback may have removed this ticker, or replaced it with one that reuses the slot
+        RBTicker *t = &ticker_pool[ticker_completed[i].slot];
+        if (t->next_free >= 0 || t->generation != ticker_completed[i].generation)
+            continue;
+        VALUE callback = t->on_complete;
+        if (!NIL_P(callback))
+            rb_proc_call_with_block(callback, 0, NULL, Qnil);
+    }
+}
+
+static int ticker_manager_mark_slot(st_data_t key, st_data_t slot, st_data_t arg)
+{
+    rb_gc_mark(ticker_pool[slot].on_complete);
+    return ST_CONTINUE;
+}
+
+static void ticker_manager_mark(void *ptr)
+{
+    RBTickerManager *manager = ptr;
+    if (manager->slots)
+        st_foreach(manager->slots, ticker_manager_mark_slot, 0);
+}
+
+static int ticker_manager_release_slot(st_data_t key, st_data_t slot, st_data_t arg)
+{
+    ticker_pool_release((int)slot);
+    return ST_CONTINUE;
+}
+
+static void ticker_manager_free(void *ptr)
+{
+    RBTickerManager *manager = ptr;
+    if (manager->slots)
+    {
+        st_foreach(manager->slots, ticker_manager_release_slot, 0);
+        st_free_table(manager->slots);
+    }
+    ruby_xfree(ptr);
+}
+
+static const rb_data_type_t ticker_manager_type =
+    {
+        "RBScene::TickerManager",
+        {ticker_manager_mark, ticker_manager_free, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+// update scheduling, objects whose class still has GameObject's empty update are skipped without a call
+// the answer is cached per class and thrown away whenever update might have changed, see gameobject.rb
+// cached classes are kept alive so a freed class's address can't be reused by one that inherits its flags
+static ID id_update;
+static ID id_sleeping;
+static unsigned int update_cache_epoch = 1;
+static st_table *update_cache = NULL; // class -> epoch << 2 | UPDATE_CACHE_* flags
+
+#define UPDATE_CACHE_GAME_OBJECT 1
+#define UPDATE_CACHE_OVERRIDES 2
+
+static VALUE game_object_invalidate_update_cache(VALUE self)
+{
+    update_cache_epoch++;
+    return Qnil;
+}
+
+static int update_class_flags(VALUE klass)
+{
+    int flags = 0;
+    if (RTEST(rb_class_inherited_p(klass, game_object_class)))
+    {
+        flags |= UPDATE_CACHE_GAME_OBJECT;
+        VALUE method = rb_funcall(klass, rb_intern("instance_method"), 1, ID2SYM(id_update));
+        if (rb_funcall(method, rb_intern("owner"), 0) != game_object_class)
+            flags |= UPDATE_CACHE_OVERRIDES;
+    }
+    return flags;
+}
+
+static int update_cache_flags(VALUE klass)
+{
+    // singleton classes come and go with their objects and are changed by extend, they're checked every time
+    if (FL_TEST(klass, FL_SINGLETON))
+        return update_class_flags(klass);
+
+    st_data_t entry;
+    bool known = st_lookup(update_cache, (st_data_t)klass, &entry);
+    if (known && (unsigned int)(entry >> 2) == update_cache_epoch)
+        return entry & 3;
+    if (!known)
+        rb_gc_register_mark_object(klass);
+
+    int flags = update_class_flags(klass);
+    st_insert(update_cache, (st_data_t)klass, ((st_data_t)update_cache_epoch << 2) | flags);
+    return flags;
+}
+
+static void update_objects(VALUE objects)
+{
+    // runs of objects of the same class are common, they skip the cache lookup too
+    VALUE last_class = Qundef;
+    unsigned int last_epoch = 0;
+    int flags = 0;
+
+    for (long i = 0; i < RARRAY_LEN(objects); i++)
+    {
+        VALUE obj_val = RARRAY_AREF(objects, i);
+
+        // CLASS_OF sees singleton classes, so an update defined on one object isn't missed
+        VALUE klass = CLASS_OF(obj_val);
+        if (klass != last_class)
+        {
+            flags = update_cache_flags(klass);
+            last_class = klass;
+            last_epoch = update_cache_epoch;
+        }
+
+        if (!(flags & UPDATE_CACHE_GAME_OBJECT))
+        {
+            VALUE obj_class = rb_obj_class(obj_val);
+            VALUE class_name = rb_class_name(obj_class);
+            rb_raise(rb_eTypeError, "Attempting to update a %s, which is not a GameObject", StringValueCStr(class_name));
+        }
+
+        if (!(flags & UPDATE_CACHE_OVERRIDES) || RTEST(rb_ivar_get(obj_val, id_sleeping)))
+            continue;
+
+        if (profile_enabled && profile_classes_enabled)
+        {
+            double start = now_seconds();
+            rb_funcall(obj_val, id_update, 0);
+            profile_class_add(rb_obj_class(obj_val), now_seconds() - start);
+        }
+        else
+        {
+            rb_funcall(obj_val, id_update, 0);
+        }
+
+        // update may have redefined methods or given something a singleton class, which bumps the epoch
+        if (update_cache_epoch != last_epoch)
+            last_class = Qundef;
+    }
+}
+
+// scratch buffer of slots that passed culling this frame
+static int *visible_slots = NULL;
+static int visible_capacity = 0;
+static unsigned int visit_stamp = 0;
+
+static void visible_push(int *count, int slot)
+{
+    if (*count == visible_capacity)
+    {
+        visible_capacity = visible_capacity ? visible_capacity * 2 : 1024;
+        REALLOC_N(visible_slots, int, visible_capacity);
+    }
+    visible_slots[(*count)++] = slot;
+}
+
+// visible slots come out of the grid in any order, the list is already sorted so its indices are the draw order
+static int compare_draw_order(const void *a, const void *b)
+{
+    int ia = render_pool.list_index[*(const int *)a];
+    int ib = render_pool.list_index[*(const int *)b];
+    return (ia > ib) - (ia < ib);
+}
+
+static void visible_test_cell(RBGridCell *cell, Rectangle view, int *count)
+{
+    for (int i = 0; i < cell->count; i++)
+    {
+        int slot = cell->slots[i];
+        if (render_pool.visit[slot] == visit_stamp)
+            continue;
+        render_pool.visit[slot] = visit_stamp;
+
+        if (rects_overlap(render_pool.bounds[slot], view))
+            visible_push(count, slot);
+    }
+}
+
+// collects the slots of a list that overlap the view rectangle into visible_slots, in draw order
+static int collect_visible(RBDrawList *list, Rectangle view)
+{
+    int count = 0;
+    RBSpatialGrid *grid = list->grid;
+
+    if (grid)
+    {
+        RBCellRange range = grid_range(grid, view);
+        long long view_cells = (long long)(range.x1 - range.x0 + 1) * (range.y1 - range.y0 + 1);
+
+        // walking the cells is only worth it while there are fewer of them than objects
+        if (view_cells < list->count - list->holes)
+        {
+            visit_stamp++;
+            for (int cy = range.y0; cy <= range.y1; cy++)
+            {
+                for (int cx = range.x0; cx <= range.x1; cx++)
+                {
+                    RBGridCell *cell = grid_cell(grid, cx, cy, false);
+                    if (cell)
+                        visible_test_cell(cell, view, &count);
+                }
+            }
+            visible_test_cell(&grid->oversize, view, &count);
+
+            qsort(visible_slots, count, sizeof(int), compare_draw_order);
+            return count;
+        }
+    }
+
+    for (int i = 0; i < list->count; i++)
+    {
+        int slot = list->slots[i];
+        if (slot >= 0 && rects_overlap(render_pool.bounds[slot], view))
+            visible_push(&count, slot);
+    }
+    return count;
+}
+
+// world space rectangle seen through the camera, handles offset, target, zoom and rotation
+static Rectangle camera_view_rect(Camera2D camera)
+{
+    Vector2 corners[4] = {
+        GetScreenToWorld2D((Vector2){0, 0}, camera),
+        GetScreenToWorld2D((Vector2){window_width, 0}, camera),
+        GetScreenToWorld2D((Vector2){0, window_height}, camera),
+        GetScreenToWorld2D((Vector2){window_width, window_height}, camera)};
+
+    float min_x = corners[0].x, min_y = corners[0].y, max_x = corners[0].x, max_y = corners[0].y;
+    for (int i = 1; i < 4; i++)
+    {
+        min_x = fminf(min_x, corners[i].x);
+        min_y = fminf(min_y, corners[i].y);
+        max_x = fmaxf(max_x, corners[i].x);
+        max_y = fmaxf(max_y, corners[i].y);
+    }
+    return (Rectangle){.x = min_x, .y = min_y, .width = max_x - min_x, .height = max_y - min_y};
+}
+
+static inline float draw_order_bottom(int slot)
+{
+    return render_pool.y[slot] - render_pool.origin_y[slot] + render_pool.height[slot];
+}
+
+static bool draw_list_batches_layer(RBDrawList *list, int layer)
+{
+    for (int i = 0; i < list->batch_layer_count; i++)
+    {
+        if (list->batch_layers[i] == layer)
+            return true;
+    }
+    return false;
+}
+
+// layer, then z, then the bottom edge in y sorted lists, then add order
+// batch layers put texture before add order, so sprites of equal z share binds but may overlap in any order
+static inline int draw_order_compare(int a, int b, RBDrawList *list)
+{
+    if (render_pool.layer[a] != render_pool.layer[b])
+        return render_pool.layer[a] < render_pool.layer[b] ? -1 : 1;
+    if (render_pool.z[a] != render_pool.z[b])
+        return render_pool.z[a] < render_pool.z[b] ? -1 : 1;
+    if (list->y_sort)
+    {
+        float ya = draw_order_bottom(a), yb = draw_order_bottom(b);
+        if (ya != yb)
+            return ya < yb ? -1 : 1;
+    }
+
+    if (list->batch_layer_count && draw_list_batches_layer(list, render_pool.layer[a]))
+    {
+        unsigned int ta = render_pool.texture[a]->texture.id, tb = render_pool.texture[b]->texture.id;
+        if (ta != tb)
+            return ta < tb ? -1 : 1;
+    }
+    return (render_pool.seq[a] > render_pool.seq[b]) - (render_pool.seq[a] < render_pool.seq[b]);
+}
+
+// qsort has no context argument, set just before sorting a list
+static RBDrawList *sort_list = NULL;
+
+static int compare_draw_key(const void *a, const void *b)
+{
+    return draw_order_compare(*(const int *)a, *(const int *)b, sort_list);
+}
+
+// the order barely changes between frames, so an insertion sort over last frame's order is close to linear
+// a lot of new or changed entries at once, like a scene's first frame, get a full sort instead
+static void draw_list_sort(RBDrawList *list)
+{
+    if (list->batch_layer_count && list->texture_changes != texture_id_changes)
+        list->unsorted++;
+    list->texture_changes = texture_id_changes;
+    if (!list->unsorted && !list->y_sort)
+        return;
+
+    int *slots = list->slots;
+    int n = list->count;
+    if (list->unsorted > 64 && list->unsorted > n / 16)
+    {
+        sort_list = list;
+        qsort(slots, n, sizeof(int), compare_draw_key);
+    }
+    else
+    {
+        for (int i = 1; i < n; i++)
+        {
+            int slot = slots[i];
+            int j = i - 1;
+            while (j >= 0 && draw_order_compare(slot, slots[j], list) < 0)
+            {
+                slots[j + 1] = slots[j];
+                j--;
+            }
+            slots[j + 1] = slot;
+        }
+    }
+
+    for (int i = 0; i < n; i++)
+        render_pool.list_index[slots[i]] = i;
+    list->unsorted = 0;
+}
+
+// squeezes out removed entries, keeping the rest in draw order
+static void draw_list_compact(RBDrawList *list)
+{
+    int live = 0;
+    for (int i = 0; i < list->count; i++)
+    {
+        int slot = list->slots[i];
+        if (slot < 0)
+            continue;
+        list->slots[live] = slot;
+        render_pool.list_index[slot] = live;
+        live++;
+    }
+    list->count = live;
+    list->holes = 0;
+}
+
+// alpha blends between the slot's previous and current position
+static void draw_slot(int slot, float alpha)
+{
+    // frames are relative to the texture's region, which is only offset for atlas regions
+    RBTexture *tex = render_pool.texture[slot];
+    Rectangle src = render_pool.frame[slot];
+    src.x += tex->region.x;
+    src.y += tex->region.y;
+    src.width = render_pool.hflip[slot] ? -src.width : src.width;
+    src.height = render_pool.vflip[slot] ? -src.height : src.height;
+
+    float x = render_pool.prev_x[slot] + (render_pool.x[slot] - render_pool.prev_x[slot]) * alpha;
+    float y = render_pool.prev_y[slot] + (render_pool.y[slot] - render_pool.prev_y[slot]) * alpha;
+
+    Rectangle dst = {
+        .x = x,
+        .y = y,
+        .width = render_pool.width[slot],
+        .height = render_pool.height[slot]};
+    Vector2 origin = {.x = render_pool.origin_x[slot], .y = render_pool.origin_y[slot]};
+
+    draw_texture(tex->texture, src, dst, origin, render_pool.angle[slot], WHITE);
+}
+
+// renders every static sprite of the cache's layer into chunks covering their combined bounds, in draw order
+// a layer with a texture still loading in the background keeps its old bake until the upload marks it dirty again
+static void static_cache_bake(RBDrawList *list, RBStaticCache *cache)
+{
+    for (int i = 0; i < list->count; i++)
+    {
+        int slot = list->slots[i];
+        if (slot >= 0 && render_pool.layer[slot] == cache->layer && slot_is_static(list, slot) &&
+            render_pool.texture[slot]->job)
+            return;
+    }
+
+    static_cache_unload(cache);
+    cache->dirty = false;
+    draw_stats_static_bakes++;
+
+    bool any = false;
+    float min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+    for (int i = 0; i < list->count; i++)
+    {
+        int slot = list->slots[i];
+        if (slot < 0 || render_pool.layer[slot] != cache->layer || !slot_is_static(list, slot))
+            continue;
+
+        Rectangle b = render_pool.bounds[slot];
+        min_x = any ? fminf(min_x, b.x) : b.x;
+        min_y = any ? fminf(min_y, b.y) : b.y;
+        max_x = any ? fmaxf(max_x, b.x + b.width) : b.x + b.width;
+        max_y = any ? fmaxf(max_y, b.y + b.height) : b.y + b.height;
+        any = true;
+    }
+    if (!any)
+        return;
+
+    cache->x = floorf(min_x);
+    cache->y = floorf(min_y);
+    int width = (int)ceilf(max_x) - (int)cache->x;
+    int height = (int)ceilf(max_y) - (int)cache->y;
+    cache->chunk_cols = (width + STATIC_CHUNK_SIZE - 1) / STATIC_CHUNK_SIZE;
+    cache->chunk_rows = (height + STATIC_CHUNK_SIZE - 1) / STATIC_CHUNK_SIZE;
+    cache->chunks = ZALLOC_N(RBStaticChunk, cache->chunk_cols * cache->chunk_rows);
+
+    // sprites far apart leave most of their combined bounds empty, those chunks never get a texture
+    bool *occupied = ZALLOC_N(bool, cache->chunk_cols * cache->chunk_rows);
+    for (int i = 0; i < list->count; i++)
+    {
+        int slot = list->slots[i];
+        if (slot < 0 || render_pool.layer[slot] != cache->layer || !slot_is_static(list, slot))
+            continue;
+
+        Rectangle b = render_pool.bounds[slot];
+        int first_cx = (int)((b.x - cache->x) / STATIC_CHUNK_SIZE);
+        int first_cy = (int)((b.y - cache->y) / STATIC_CHUNK_SIZE);
+        int last_cx = (int)((b.x + b.width - cache->x) / STATIC_CHUNK_SIZE);
+        int last_cy = (int)((b.y + b.height - cache->y) / STATIC_CHUNK_SIZE);
+        for (int cy = first_cy; cy <= last_cy && cy < cache->chunk_rows; cy++)
+        {
+            for (int cx = first_cx; cx <= last_cx && cx < cache->chunk_cols; cx++)
+                occupied[cy * cache->chunk_cols + cx] = true;
+        }
+    }
+
+    for (int cy = 0; cy < cache->chunk_rows; cy++)
+    {
+        for (int cx = 0; cx < cache->chunk_cols; cx++)
+        {
+            if (!occupied[cy * cache->chunk_cols + cx])
+                continue;
+
+            Rectangle area = {
+                .x = cache->x + cx * STATIC_CHUNK_SIZE,
+                .y = cache->y + cy * STATIC_CHUNK_SIZE,
+                .width = width - cx * STATIC_CHUNK_SIZE < STATIC_CHUNK_SIZE ? width - cx * STATIC_CHUNK_SIZE : STATIC_CHUNK_SIZE,
+                .height = height - cy * STATIC_CHUNK_SIZE < STATIC_CHUNK_SIZE ? height - cy * STATIC_CHUNK_SIZE : STATIC_CHUNK_SIZE};
+
+            RBStaticChunk *chunk = &cache->chunks[cy * cache->chunk_cols + cx];
+            chunk->target = LoadRenderTexture(area.width, area.height);
+            chunk->loaded = true;
+            RenderTexture2D *target = &chunk->target;
+
+            BeginTextureMode(*target);
+            ClearBackground(BLANK);
+            BeginMode2D((Camera2D){.target = {area.x, area.y}, .zoom = 1.0f});
+            for (int i = 0; i < list->count; i++)
+            {
+                int slot = list->slots[i];
+                if (slot < 0 || render_pool.layer[slot] != cache->layer || !slot_is_static(list, slot))
+                    continue;
+                if (rects_overlap(render_pool.bounds[slot], area))
+                    draw_slot(slot, 1.0f);
+            }
+            EndMode2D();
+            EndTextureMode();
+        }
+    }
+    xfree(occupied);
+}
+
+// texture mode can't be nested in the camera's mode, so this runs before it starts
+static void draw_list_bake_static(RBDrawList *list)
+{
+    if (!list->static_count)
+        return;
+
+    if (list->holes)
+        draw_list_compact(list);
+    draw_list_sort(list);
+
+    for (int i = 0; i < list->static_count; i++)
+    {
+        if (list->statics[i].dirty)
+            static_cache_bake(list, &list->statics[i]);
+    }
+}
+
+static void static_cache_draw(RBStaticCache *cache, Rectangle view)
+{
+    if (!cache->chunks)
+        return;
+
+    for (int cy = 0; cy < cache->chunk_rows; cy++)
+    {
+        for (int cx = 0; cx < cache->chunk_cols; cx++)
+        {
+            RBStaticChunk *chunk = &cache->chunks[cy * cache->chunk_cols + cx];
+            if (!chunk->loaded)
+                continue;
+
+            // render textures are stored upside down
+            Texture2D texture = chunk->target.texture;
+            Rectangle dst = {
+                .x = cache->x + cx * STATIC_CHUNK_SIZE,
+                .y = cache->y + cy * STATIC_CHUNK_SIZE,
+                .width = texture.width,
+                .height = texture.height};
+            if (rects_overlap(dst, view))
+                draw_texture(texture, (Rectangle){0, 0, texture.width, -texture.height}, dst, (Vector2){0, 0}, 0, WHITE);
+        }
+    }
+}
+
+static void draw_objects(RBDrawList *list, Rectangle view)
+{
+    if (list->holes)
+        draw_list_compact(list);
+    draw_list_sort(list);
+
+    int count = collect_visible(list, view);
+    draw_stats_drawn += count;
+    draw_stats_culled += list->count - count;
+
+    // walks the render pool directly, no Ruby objects are touched here
+    // each static cache goes down before the first of its layer's other sprites
+    unsigned int bound_texture = 0;
+    int next_static = 0;
+    int dynamic_layer = 0;
+    bool dynamic_seen = false; // a dynamic sprite on dynamic_layer was drawn, and its z was dynamic_z
+    float dynamic_z = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int slot = visible_slots[i];
+
+        while (next_static < list->static_count && list->statics[next_static].layer <= render_pool.layer[slot])
+            static_cache_draw(&list->statics[next_static++], view);
+
+        if (list->static_count && slot_is_static(list, slot))
+        {
+            // the cache already went down underneath, so this sprite draws lower than its z asks for
+            if (dynamic_seen && dynamic_layer == render_pool.layer[slot] && render_pool.z[slot] > dynamic_z &&
+                !list->static_z_warned)
+            {
+                list->static_z_warned = true;
+                rb_warn("static sprites on layer %d are drawn below its dynamic sprites regardless of z",
+                        render_pool.layer[slot]);
+            }
+            draw_stats_drawn--;
+            draw_stats_static++;
+            continue;
+        }
+        if (list->static_count && (!dynamic_seen || dynamic_layer != render_pool.layer[slot]))
+        {
+            dynamic_seen = true;
+            dynamic_layer = render_pool.layer[slot];
+            dynamic_z = render_pool.z[slot];
+        }
+
+        RBTexture *tex = render_pool.texture[slot];
+        if (tex->texture.id != bound_texture)
+        {
+            bound_texture = tex->texture.id;
+            draw_stats_texture_switches++;
+        }
+
+        // drawn between the last two simulation steps, culling still uses the current position
+        draw_slot(slot, draw_alpha);
+    }
+    while (next_static < list->static_count)
+        static_cache_draw(&list->statics[next_static++], view);
+}
+
+static RBDrawList *get_draw_list(VALUE scene, const char *name)
+{
+    VALUE list_val = rb_iv_get(scene, name);
+    RBDrawList *list;
+    TypedData_Get_Struct(list_val, RBDrawList, &draw_list_type, list);
+    return list;
+}
+
+static void collision_world_push_pair(RBCollisionWorld *world, int a, int b)
+{
+    if (world->pair_count == world->pair_capacity)
+    {
+        world->pair_capacity = world->pair_capacity ? world->pair_capacity * 2 : 64;
+        REALLOC_N(world->pairs, RBCollisionPair, world->pair_capacity);
+    }
+    world->pairs[world->pair_count++] = (RBCollisionPair){
+        .a = world->objects[a],
+        .b = world->objects[b],
+        .slot_a = world->slots[a],
+        .slot_b = world->slots[b]};
+}
+
+// sweep and prune along the x axis, the sort order is kept between frames so the insertion sort stays close to linear
+static void collision_world_step(RBCollisionWorld *world)
+{
+    for (int i = 0; i < world->count; i++)
+    {
+        int slot = world->slots[i];
+        Rectangle hitbox = world->hitboxes[i];
+        world->aabbs[i] = (Rectangle){
+            .x = render_pool.x[slot] - render_pool.origin_x[slot] + hitbox.x,
+            .y = render_pool.y[slot] - render_pool.origin_y[slot] + hitbox.y,
+            .width = hitbox.width,
+            .height = hitbox.height};
+    }
+
+    // drop holes left by removed bodies
+    int n = 0;
+    for (int i = 0; i < world->order_count; i++)
+    {
+        if (world->order[i] >= 0)
+            world->order[n++] = world->order[i];
+    }
+    world->order_count = n;
+
+    Rectangle *aabbs = world->aabbs;
+    int *order = world->order;
+    for (int i = 1; i < n; i++)
+    {
+        int body = order[i];
+        float x = aabbs[body].x;
+        int j = i - 1;
+        while (j >= 0 && aabbs[order[j]].x > x)
+        {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = body;
+    }
+    for (int i = 0; i < n; i++)
+        world->order_pos[order[i]] = i;
+
+    world->pair_count = 0;
+    for (int i = 0; i < n; i++)
+    {
+        Rectangle a = aabbs[order[i]];
+        float right = a.x + a.width;
+
+        for (int j = i + 1; j < n && aabbs[order[j]].x < right; j++)
+        {
+            Rectangle b = aabbs[order[j]];
+            if (a.y < b.y + b.height && a.y + a.height > b.y)
+                collision_world_push_pair(world, order[i], order[j]);
+        }
+    }
+}
+
+static bool collision_world_contains(RBCollisionWorld *world, VALUE obj, int slot)
+{
+    return render_pool.body_world[slot] == world && world->objects[render_pool.body[slot]] == obj;
+}
+
+// calls on_collide on both sides of every pair found by the last step
+// objects removed by an earlier callback in the same pass are skipped
+static void collision_world_dispatch(RBCollisionWorld *world)
+{
+    ID on_collide = rb_intern("on_collide");
+
+    for (int i = 0; i < world->pair_count; i++)
+    {
+        RBCollisionPair pair = world->pairs[i];
+
+        if (!collision_world_contains(world, pair.a, pair.slot_a) || !collision_world_contains(world, pair.b, pair.slot_b))
+            continue;
+
+        if (world->callbacks[render_pool.body[pair.slot_a]])
+            rb_funcall(pair.a, on_collide, 1, pair.b);
+
+        if (!collision_world_contains(world, pair.a, pair.slot_a) || !collision_world_contains(world, pair.b, pair.slot_b))
+            continue;
+
+        if (world->callbacks[render_pool.body[pair.slot_b]])
+            rb_funcall(pair.b, on_collide, 1, pair.a);
+    }
+}
+
+static VALUE get_current_scene(void)
+{
+    VALUE scene = rb_iv_get(engine_class, "@current_scene");
+    if (!rb_obj_is_kind_of(scene, scene_class))
+    {
+        rb_raise(rb_eTypeError, "Internal error: No active scene. There might be an issue with your config.rb, or your scene switching logic.");
+    }
+    return scene;
+}
+
+static void emitter_mark(void *ptr)
+{
+    RBEmitter *emitter = ptr;
+    rb_gc_mark(emitter->texture);
+}
+
+static void emitter_free_particles(RBEmitter *emitter)
+{
+    xfree(emitter->x);
+    xfree(emitter->y);
+    xfree(emitter->vx);
+    xfree(emitter->vy);
+    xfree(emitter->life);
+    xfree(emitter->inv_lifetime);
+    xfree(emitter->size);
+    xfree(emitter->frame);
+}
+
+static void emitter_free(void *ptr)
+{
+    RBEmitter *emitter = ptr;
+    emitter_free_particles(emitter);
+    xfree(emitter->frames);
+    xfree(emitter);
+}
+
+static const rb_data_type_t emitter_type =
+    {
+        .wrap_struct_name = "RBScene::Emitter",
+        .function = {.dmark = emitter_mark, .dfree = emitter_free},
+        .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+static RBEmitter *get_emitter(VALUE self)
+{
+    RBEmitter *emitter;
+    TypedData_Get_Struct(self, RBEmitter, &emitter_type, emitter);
+    return emitter;
+}
+
+// xorshift32, each emitter has its own state so seeded emitters replay the same particles
+static inline float emitter_random(RBEmitter *emitter)
+{
+    uint32_t r = emitter->rng;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    emitter->rng = r;
+    return (r >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline float emitter_pick(RBEmitter *emitter, RBRange range)
+{
+    return range.min + (range.max - range.min) * emitter_random(emitter);
+}
+
+static void emitter_spawn(RBEmitter *emitter, int n)
+{
+    if (n > emitter->capacity - emitter->count)
+        n = emitter->capacity - emitter->count;
+
+    for (int i = emitter->count; i < emitter->count + n; i++)
+    {
+        emitter->x[i] = emitter->spawn_x + emitter->spawn_width * emitter_random(emitter);
+        emitter->y[i] = emitter->spawn_y + emitter->spawn_height * emitter_random(emitter);
+        emitter->vx[i] = emitter_pick(emitter, emitter->velocity_x);
+        emitter->vy[i] = emitter_pick(emitter, emitter->velocity_y);
+
+        float life = emitter_pick(emitter, emitter->lifetime);
+        if (life <= 0)
+            life = step_dt;
+        emitter->life[i] = life;
+        emitter->inv_lifetime[i] = 1.0f / life;
+
+        emitter->size[i] = emitter_pick(emitter, emitter->size_range);
+        emitter->frame[i] = emitter->frame_count > 1 ? (unsigned short)(emitter_random(emitter) * emitter->frame_count) : 0;
+    }
+    emitter->count += n;
+}
+
+static void emitter_step(RBEmitter *emitter, float dt)
+{
+    // new particles move this step too, debt past capacity is dropped rather than bursting out later
+    if (emitter->emitting)
+    {
+        emitter->spawn_debt += emitter->rate * dt;
+        int n = (int)emitter->spawn_debt;
+        emitter->spawn_debt -= n;
+        emitter_spawn(emitter, n);
+    }
+
+    int n = emitter->count;
+    float *restrict x = emitter->x;
+    float *restrict y = emitter->y;
+    float *restrict vx = emitter->vx;
+    float *restrict vy = emitter->vy;
+    float *restrict life = emitter->life;
+    float gx = emitter->gravity.x * dt;
+    float gy = emitter->gravity.y * dt;
+
+    for (int i = 0; i < n; i++)
+    {
+        vx[i] += gx;
+        vy[i] += gy;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        life[i] -= dt;
+    }
+
+    // dead particles are squeezed out in order, kept out of the loop above so it stays branch free
+    int live = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (life[i] <= 0)
+            continue;
+        if (live != i)
+        {
+            x[live] = x[i];
+            y[live] = y[i];
+            vx[live] = vx[i];
+            vy[live] = vy[i];
+            life[live] = life[i];
+            emitter->inv_lifetime[live] = emitter->inv_lifetime[i];
+            emitter->size[live] = emitter->size[i];
+            emitter->frame[live] = emitter->frame[i];
+        }
+        live++;
+    }
+    emitter->count = live;
+}
+
+#define EMITTER_BATCH_QUADS 1024
+
+// every particle goes out as a textured quad in as few rlgl batches as fit, instead of a draw call each
+static void emitter_draw(RBEmitter *emitter, Rectangle view)
+{
+    if (emitter->count == 0)
+        return;
+
+    unsigned int texture_id = rlGetTextureIdDefault();
+    Rectangle region = {0, 0, 1, 1};
+    float texture_width = 1, texture_height = 1;
+    if (!NIL_P(emitter->texture))
+    {
+        RBTexture *tex;
+        TypedData_Get_Struct(emitter->texture, RBTexture, &texture_type, tex);
+        texture_id = tex->texture.id;
+        region = tex->region;
+        texture_width = tex->texture.width;
+        texture_height = tex->texture.height;
+    }
+    Rectangle whole = {0, 0, region.width, region.height};
+
+    // particles don't keep their previous position, stepping back along velocity is close enough
+    float back = (draw_alpha - 1.0f) * step_dt;
+    Color from = emitter->start_color, to = emitter->end_color;
+
+    for (int start = 0; start < emitter->count; start += EMITTER_BATCH_QUADS)
+    {
+        int end = start + EMITTER_BATCH_QUADS < emitter->count ? start + EMITTER_BATCH_QUADS : emitter->count;
+
+        rlCheckRenderBatchLimit((end - start) * 4);
+        rlSetTexture(texture_id);
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+
+        for (int i = start; i < end; i++)
+        {
+            Rectangle frame = emitter->frame_count ? emitter->frames[emitter->frame[i]] : whole;
+            float w = emitter->size[i];
+            float h = frame.width > 0 ? w * frame.height / frame.width : w;
+            float left = emitter->x[i] + emitter->vx[i] * back - w * 0.5f;
+            float top = emitter->y[i] + emitter->vy[i] * back - h * 0.5f;
+
+            if (left > view.x + view.width || left + w < view.x || top > view.y + view.height || top + h < view.y)
+                continue;
+
+            float t = 1.0f - emitter->life[i] * emitter->inv_lifetime[i];
+            rlColor4ub(from.r + (to.r - from.r) * t, from.g + (to.g - from.g) * t,
+                       from.b + (to.b - from.b) * t, from.a + (to.a - from.a) * t);
+
+            float u0 = (region.x + frame.x) / texture_width;
+            float v0 = (region.y + frame.y) / texture_height;
+            float u1 = (region.x + frame.x + frame.width) / texture_width;
+            float v1 = (region.y + frame.y + frame.height) / texture_height;
+
+            rlTexCoord2f(u0, v0);
+            rlVertex2f(left, top);
+            rlTexCoord2f(u0, v1);
+            rlVertex2f(left, top + h);
+            rlTexCoord2f(u1, v1);
+            rlVertex2f(left + w, top + h);
+            rlTexCoord2f(u1, v0);
+            rlVertex2f(left + w, top);
+        }
+
+        rlEnd();
+    }
+    rlSetTexture(0);
+    frame_draw_calls++;
+}
+
+static void scene_step_emitters(VALUE scene)
+{
+    VALUE emitters = rb_iv_get(scene, "@emitters");
+    Check_Type(emitters, T_ARRAY);
+
+    for (long i = 0; i < RARRAY_LEN(emitters); i++)
+        emitter_step(get_emitter(RARRAY_AREF(emitters, i)), step_dt);
+}
+
+static void scene_draw_emitters(VALUE scene, Rectangle view)
+{
+    VALUE emitters = rb_iv_get(scene, "@emitters");
+    Check_Type(emitters, T_ARRAY);
+
+    for (long i = 0; i < RARRAY_LEN(emitters); i++)
+    {
+        RBEmitter *emitter = get_emitter(RARRAY_AREF(emitters, i));
+        draw_stats_particles += emitter->count;
+        if (!headless)
+            emitter_draw(emitter, view);
+    }
+}
+
+static void tilemap_mark(void *ptr)
+{
+    RBTilemap *map = ptr;
+    rb_gc_mark(map->tileset);
+}
+
+static void tilemap_free_chunks(RBTilemap *map)
+{
+    for (int i = 0; i < map->chunk_cols * map->chunk_rows; i++)
+    {
+        if (map->chunks[i].loaded)
+            UnloadRenderTexture(map->chunks[i].target);
+    }
+    xfree(map->chunks);
+    map->chunks = NULL;
+}
+
+static void tilemap_free(void *ptr)
+{
+    RBTilemap *map = ptr;
+    tilemap_free_chunks(map);
+    xfree(map->tiles);
+    xfree(map->solid);
+    xfree(map);
+}
+
+static const rb_data_type_t tilemap_type =
+    {
+        .wrap_struct_name = "RBScene::Tilemap",
+        .function = {.dmark = tilemap_mark, .dfree = tilemap_free},
+        .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+static RBTilemap *get_tilemap(VALUE self)
+{
+    RBTilemap *map;
+    TypedData_Get_Struct(self, RBTilemap, &tilemap_type, map);
+    return map;
+}
+
+// range of tiles touching a world space rect, clamped to the map, empty when x0 > x1 or y0 > y1
+static RBCellRange tilemap_range(RBTilemap *map, Rectangle rect)
+{
+    RBCellRange range = {
+        .x0 = (int)floorf((rect.x - map->x) / map->tile_width),
+        .y0 = (int)floorf((rect.y - map->y) / map->tile_height),
+        .x1 = (int)ceilf((rect.x + rect.width - map->x) / map->tile_width) - 1,
+        .y1 = (int)ceilf((rect.y + rect.height - map->y) / map->tile_height) - 1};
+
+    if (range.x0 < 0)
+        range.x0 = 0;
+    if (range.y0 < 0)
+        range.y0 = 0;
+    if (range.x1 >= map->cols)
+        range.x1 = map->cols - 1;
+    if (range.y1 >= map->rows)
+        range.y1 = map->rows - 1;
+    return range;
+}
+
+static bool tilemap_solid_tile(RBTilemap *map, int col, int row)
+{
+    int id = map->tiles[row * map->cols + col];
+    return id >= 0 && id < map->solid_count && map->solid[id];
+}
+
+static void tilemap_render_chunk(RBTilemap *map, int cx, int cy)
+{
+    RBTileChunk *chunk = &map->chunks[cy * map->chunk_cols + cx];
+    int col0 = cx * TILEMAP_CHUNK_TILES, row0 = cy * TILEMAP_CHUNK_TILES;
+    int cols = map->cols - col0 < TILEMAP_CHUNK_TILES ? map->cols - col0 : TILEMAP_CHUNK_TILES;
+    int rows = map->rows - row0 < TILEMAP_CHUNK_TILES ? map->rows - row0 : TILEMAP_CHUNK_TILES;
+
+    if (!chunk->loaded)
+    {
+        chunk->target = LoadRenderTexture(cols * map->tile_width, rows * map->tile_height);
+        chunk->loaded = true;
+    }
+
+    RBTexture *tex;
+    TypedData_Get_Struct(map->tileset, RBTexture, &texture_type, tex);
+
+    BeginTextureMode(chunk->target);
+    ClearBackground(BLANK);
+    for (int row = 0; row < rows; row++)
+    {
+        for (int col = 0; col < cols; col++)
+        {
+            int id = map->tiles[(row0 + row) * map->cols + col0 + col];
+            if (id < 0 || id >= map->tile_count)
+                continue;
+
+            Rectangle src = {
+                .x = tex->region.x + (id % map->tileset_cols) * map->tile_width,
+                .y = tex->region.y + (id / map->tileset_cols) * map->tile_height,
+                .width = map->tile_width,
+                .height = map->tile_height};
+            Rectangle dst = {col * map->tile_width, row * map->tile_height, map->tile_width, map->tile_height};
+            draw_texture(tex->texture, src, dst, (Vector2){0, 0}, 0, WHITE);
+        }
+    }
+    EndTextureMode();
+
+    chunk->dirty = false;
+    draw_stats_chunk_renders++;
+}
+
+// chunks are rendered into their textures outside the camera's 2D mode, only the visible dirty ones
+static void tilemap_render_dirty(RBTilemap *map, Rectangle view)
+{
+    RBCellRange range = tilemap_range(map, view);
+    for (int cy = range.y0 / TILEMAP_CHUNK_TILES; cy <= range.y1 / TILEMAP_CHUNK_TILES && range.y0 <= range.y1; cy++)
+    {
+        for (int cx = range.x0 / TILEMAP_CHUNK_TILES; cx <= range.x1 / TILEMAP_CHUNK_TILES && range.x0 <= range.x1; cx++)
+        {
+            if (map->chunks[cy * map->chunk_cols + cx].dirty)
+                tilemap_render_chunk(map, cx, cy);
+        }
+    }
+}
+
+static void tilemap_draw(RBTilemap *map, Rectangle view)
+{
+    RBCellRange range = tilemap_range(map, view);
+    for (int cy = range.y0 / TILEMAP_CHUNK_TILES; cy <= range.y1 / TILEMAP_CHUNK_TILES && range.y0 <= range.y1; cy++)
+    {
+        for (int cx = range.x0 / TILEMAP_CHUNK_TILES; cx <= range.x1 / TILEMAP_CHUNK_TILES && range.x0 <= range.x1; cx++)
+        {
+            draw_stats_chunks++;
+            if (headless)
+                continue;
+
+            // render textures are stored upside down
+            Texture2D texture = map->chunks[cy * map->chunk_cols + cx].target.texture;
+            Rectangle src = {0, 0, texture.width, -texture.height};
+            Rectangle dst = {
+                .x = map->x + cx * TILEMAP_CHUNK_TILES * map->tile_width,
+                .y = map->y + cy * TILEMAP_CHUNK_TILES * map->tile_height,
+                .width = texture.width,
+                .height = texture.height};
+            draw_texture(texture, src, dst, (Vector2){0, 0}, 0, WHITE);
+        }
+    }
+}
+
+static void scene_render_tilemaps(VALUE scene, Rectangle view)
+{
+    VALUE tilemaps = rb_iv_get(scene, "@tilemaps");
+    Check_Type(tilemaps, T_ARRAY);
+
+    for (long i = 0; i < RARRAY_LEN(tilemaps); i++)
+        tilemap_render_dirty(get_tilemap(RARRAY_AREF(tilemaps, i)), view);
+}
+
+static void scene_draw_tilemaps(VALUE scene, Rectangle view)
+{
+    VALUE tilemaps = rb_iv_get(scene, "@tilemaps");
+    Check_Type(tilemaps, T_ARRAY);
+
+    for (long i = 0; i < RARRAY_LEN(tilemaps); i++)
+        tilemap_draw(get_tilemap(RARRAY_AREF(tilemaps, i)), view);
+}
+
+// creates and destroys made during a step are queued by the scene and applied here, between steps
+static void scene_apply_pending(VALUE scene)
+{
+    VALUE spawns = rb_iv_get(scene, "@spawn_queue");
+    VALUE despawns = rb_iv_get(scene, "@despawn_queue");
+    Check_Type(spawns, T_ARRAY);
+    Check_Type(despawns, T_ARRAY);
+
+    if (RARRAY_LEN(spawns) > 0 || RARRAY_LEN(despawns) > 0)
+        rb_funcall(scene, rb_intern("apply_pending"), 0);
+}
+
+// one fixed step of game logic, scenes only switch at the start of a frame so it's the same one throughout
+static void engine_step(void)
+{
+    VALUE scene = get_current_scene();
+    engine_stepping = true;
+
+    // fetch the current scene's objects
+    VALUE objects = rb_iv_get(scene, "@objects");
+    Check_Type(objects, T_ARRAY);
+
+    VALUE ui_objects = rb_iv_get(scene, "@ui_objects");
+    Check_Type(ui_objects, T_ARRAY);
+
+    render_pool_snapshot();
+
+    // every object's tickers advance in one pass, so they read this step's values during update
+    ticker_pool_advance();
+    PROFILE_LAP(PROFILE_TICKERS);
+
+    // update loop
+    update_objects(objects);
+    PROFILE_LAP(PROFILE_UPDATE_WORLD);
+    update_objects(ui_objects);
+    PROFILE_LAP(PROFILE_UPDATE_UI);
+
+    // particles spawn from wherever update left their emitters
+    scene_step_emitters(scene);
+    PROFILE_LAP(PROFILE_PARTICLES);
+
+    // collisions are found after objects move, so the scene's update sees this step's pairs
+    VALUE collision_world_val = rb_iv_get(scene, "@collision_world");
+    RBCollisionWorld *collision_world;
+    TypedData_Get_Struct(collision_world_val, RBCollisionWorld, &collision_world_type, collision_world);
+    collision_world_step(collision_world);
+    collision_world_dispatch(collision_world);
+    PROFILE_LAP(PROFILE_COLLISION);
+
+    rb_funcall(scene, rb_intern("update"), 0);
+
+    // creates and destroys queued during the step, a switch asked for in update waits for the next frame
+    engine_stepping = false;
+    scene_apply_pending(scene);
+    PROFILE_LAP(PROFILE_SCENE_UPDATE);
+
+    input_end_step();
+    step_count++;
+}
+
+static VALUE engine_run_frames(VALUE self)
+{
+    RBEngineConfig config = get_engine_config();
+
+    step_dt = config.fixed_dt;
+    stop_requested = false;
+    frame_count = 0;
+    step_count = 0;
+    frame_log_count = 0;
+
+    // game logic runs in fixed steps of fixed_dt, however long frames take
+    // the clock starts one step back so the first frame updates once
+    double accumulator = 0;
+    double max_elapsed = config.fixed_dt * config.max_substeps;
+    double last_time = now_seconds() - config.fixed_dt;
+    gc_begin_run(&config);
+
+    while (!engine_should_stop(&config))
+    {
+        double frame_start = now_seconds();
+        if (profile_enabled)
+            profile_begin_frame(frame_count);
+        gc_begin_frame();
+        VALUE scene_switches = rb_iv_get(engine_class, "@scene_switches");
+
+        // headless runs exactly one step per frame so results don't depend on the machine
+        double elapsed = headless ? config.fixed_dt : frame_start - last_time;
+        last_time = frame_start;
+        accumulator += elapsed < max_elapsed ? elapsed : max_elapsed;
+
+        // upload whatever the loader threads finished decoding since last frame
+        loader_process_completed(config.asset_upload_budget);
+
+        // a scene switched to last frame swaps in here once its preloads are uploaded, see Engine.switch_scene
+        if (!NIL_P(rb_iv_get(engine_class, "@pending_switch")))
+            rb_funcall(engine_class, rb_intern("advance_switch"), 0);
+        PROFILE_LAP(PROFILE_ASSETS);
+
+        // handle inputs
+        input_poll();
+        PROFILE_LAP(PROFILE_INPUT);
+
+        audio_reap(NULL);
+        PROFILE_LAP(PROFILE_AUDIO);
+
+        // catch up on however many steps fit in the time since last frame
+        for (int steps = 0; accumulator >= config.fixed_dt && steps < config.max_substeps; steps++)
+        {
+            engine_step();
+            accumulator -= config.fixed_dt;
+        }
+        if (accumulator > config.fixed_dt)
+            accumulator = config.fixed_dt;
+
+        draw_alpha = config.interpolate ? accumulator / config.fixed_dt : 1.0f;
+
+        VALUE scene = get_current_scene();
+        RBDrawList *draw_list = get_draw_list(scene, "@draw_list");
+        RBDrawList *ui_draw_list = get_draw_list(scene, "@ui_draw_list");
+
+        if (!headless)
+        {
+            BeginDrawing();
+            ClearBackground(RAYWHITE);
+        }
+
+        // fetch camera from scene, will raise error if no camera object exists
+        VALUE camera_val = rb_iv_get(scene, "@camera");
+        TypedData_Get_Struct(camera_val, Camera2D, &camera_type, cam);
+        Rectangle view = camera_view_rect(*cam);
+
+        draw_stats_drawn = 0;
+        draw_stats_culled = 0;
+        draw_stats_particles = 0;
+        draw_stats_chunks = 0;
+        draw_stats_chunk_renders = 0;
+        draw_stats_texture_switches = 0;
+        draw_stats_static = 0;
+        draw_stats_static_bakes = 0;
+        frame_draw_calls = 0;
+        render_pool_flush_dirty();
+
+        // texture mode can't be nested in the camera's mode, so changed tilemap chunks and static layers are redrawn first
+        if (!headless)
+        {
+            scene_render_tilemaps(scene, view);
+            draw_list_bake_static(draw_list);
+            draw_list_bake_static(ui_draw_list);
+            BeginMode2D(*cam);
+        }
+
+        // draw loop, only objects inside the camera's view are drawn, tilemaps go underneath them
+        scene_draw_tilemaps(scene, view);
+        draw_objects(draw_list, view);
+        scene_draw_emitters(scene, view);
+        PROFILE_LAP(PROFILE_DRAW_WORLD);
+
+        // debug drawing
+        VALUE debug_rects_val = rb_iv_get(debug_class, "@rects");
+        Check_Type(debug_rects_val, T_ARRAY);
+
+        for (int i = 0; i < RARRAY_LEN(debug_rects_val); i++)
+        {
+            VALUE obj_val = rb_ary_entry(debug_rects_val, i);
+            if (rb_obj_is_kind_of(obj_val, rect_class))
+            {
+                Rectangle *rect;
+                TypedData_Get_Struct(obj_val, Rectangle, &rect_type, rect);
+                if (!headless)
+                    DrawRectangleLinesEx(*rect, 1, RED);
+            }
+            else
+            {
+                VALUE obj_class = rb_obj_class(obj_val);
+                VALUE class_name = rb_class_name(obj_class);
+                rb_raise(rb_eTypeError, "Attempting to debug draw a %s, which is not a Rect", StringValueCStr(class_name));
+            }
+        }
+
+        if (!headless)
+            EndMode2D();
+        PROFILE_LAP(PROFILE_DEBUG_DRAW);
+
+        // UI drawing (no camera transforms)
+        draw_objects(ui_draw_list, (Rectangle){0, 0, window_width, window_height});
+        PROFILE_LAP(PROFILE_DRAW_UI);
+
+        gc_end_frame(&config, frame_start, !rb_eql(scene_switches, rb_iv_get(engine_class, "@scene_switches")));
+        PROFILE_LAP(PROFILE_GC);
+
+        if (profile_enabled && profile_overlay && !headless)
+            profile_draw_overlay();
+
+        // with a window, present includes waiting for the target_fps frame cap
+        if (!headless)
+            EndDrawing();
+        PROFILE_LAP(PROFILE_PRESENT);
+
+        frame_count++;
+        if (config.record_frame_times)
+            frame_log_push(now_seconds() - frame_start);
+    }
+    return Qnil;
+}
+
+// runs however the frame loop ends, so an exception out of it doesn't leave GC switched off,
+// the loader and music threads running or the window open
+static VALUE engine_run_finish(VALUE arg)
+{
+    // should not need to clean up loaded textures and audio, when Ruby closes they should be GC'd
+    loader_stop();
+    music_thread_stop();
+    if (!headless)
+    {
+        CloseAudioDevice();
+        CloseWindow();
+    }
+    gc_end_run();
+    return Qnil;
+}
+
+static VALUE engine_run(VALUE self)
+{
+    return rb_ensure(engine_run_frames, self, engine_run_finish, Qnil);
+}
+
+static VALUE assets_load_texture(VALUE self, VALUE filename)
+{
+    Check_Type(filename, T_STRING);
+
+    VALUE cache_val = rb_iv_get(self, "@textures");
+    Check_Type(cache_val, T_HASH);
+
+    VALUE texture_val = rb_hash_lookup(cache_val, filename);
+    assert(rb_obj_is_kind_of(texture_val, texture_class));
+
+    if (texture_val == Qnil)
+    {
+        // cache doesn't have an entry at this key, make a new one
+        double start = now_seconds();
+        RBTexture *tex;
+        texture_val = TypedData_Make_Struct(texture_class, RBTexture, &texture_type, tex);
+        tex->texture = texture_from_file(StringValueCStr(filename));
+        tex->region = (Rectangle){0, 0, tex->texture.width, tex->texture.height};
+        tex->owned = true;
+        tex->page = Qnil;
+        asset_set_bytes(&tex->info, texture_bytes(tex->texture));
+        asset_stats_record(start, StringValueCStr(filename));
+        // TODO: should raise error if texture loading failed
+        asset_cache(cache_val, filename, texture_val);
+    }
+    else
+    {
+        // might still be loading in the background, a synchronous load has to wait for it
+        RBTexture *tex;
+        TypedData_Get_Struct(texture_val, RBTexture, &texture_type, tex);
+        texture_ensure_loaded(tex);
+        asset_use(texture_val, true);
+    }
+
+    // if cache already has this entry, just return it
+    return texture_val;
+}
+
+// returns immediately with a texture that is decoded on a loader thread and uploaded during a later frame
+// using it before then, eg. for its size or to create a game object, waits for it to finish
+static VALUE assets_load_texture_async(VALUE self, VALUE filename)
+{
+    Check_Type(filename, T_STRING);
+
+    VALUE cache_val = rb_iv_get(self, "@textures");
+    Check_Type(cache_val, T_HASH);
+
+    // cached entries are either loaded or already in flight, either way there's nothing to queue
+    VALUE texture_val = rb_hash_lookup(cache_val, filename);
+    if (texture_val != Qnil)
+    {
+        asset_use(texture_val, true);
+        return texture_val;
+    }
+
+    RBTexture *tex;
+    texture_val = TypedData_Make_Struct(texture_class, RBTexture, &texture_type, tex);
+    tex->owned = true;
+    tex->page = Qnil;
+    tex->job = loader_enqueue(ASSET_JOB_TEXTURE, filename, tex);
+    asset_cache(cache_val, filename, texture_val);
+
+    return texture_val;
+}
+
+static VALUE assets_load_sound(VALUE self, VALUE filename)
+{
+    Check_Type(filename, T_STRING);
+
+    VALUE cache_val = rb_iv_get(self, "@sounds");
+    Check_Type(cache_val, T_HASH);
+
+    VALUE sound_val = rb_hash_lookup(cache_val, filename);
+    assert(rb_obj_is_kind_of(sound_val, sound_class));
+
+    if (sound_val == Qnil)
+    {
+        // cache doesn't have an entry at this key, make a new one
+        double start = now_seconds();
+        RBSound *sound;
+        sound_val = TypedData_Make_Struct(sound_class, RBSound, &sound_type, sound);
+        sound->sound = sound_from_file(StringValueCStr(filename));
+        sound->max_voices = SOUND_DEFAULT_VOICES;
+        asset_set_bytes(&sound->info, sound_bytes(sound->sound));
+        asset_stats_record(start, StringValueCStr(filename));
+        // TODO: should raise error if sound loading failed
+        asset_cache(cache_val, filename, sound_val);
+    }
+    else
+    {
+        RBSound *sound;
+        TypedData_Get_Struct(sound_val, RBSound, &sound_type, sound);
+        sound_ensure_loaded(sound);
+        asset_use(sound_val, true);
+    }
+
+    // if cache already has this entry, just return it
+    return sound_val;
+}
+
+static VALUE assets_load_sound_async(VALUE self, VALUE filename)
+{
+    Check_Type(filename, T_STRING);
+
+    VALUE cache_val = rb_iv_get(self, "@sounds");
+    Check_Type(cache_val, T_HASH);
+
+    VALUE sound_val = rb_hash_lookup(cache_val, filename);
+    if (sound_val != Qnil)
+    {
+        asset_use(sound_val, true);
+        return sound_val;
+    }
+
+    RBSound *sound;
+    sound_val = TypedData_Make_Struct(sound_class, RBSound, &sound_type, sound);
+    sound->max_voices = SOUND_DEFAULT_VOICES;
+    sound->job = loader_enqueue(ASSET_JOB_SOUND, filename, sound);
+    asset_cache(cache_val, filename, sound_val);
+
+    return sound_val;
+}
+
+// fraction of background loads finished since the loader was last idle, 1.0 when nothing is loading
+static VALUE assets_progress(VALUE self)
+{
+    if (loader_jobs_total == 0)
+        return DBL2NUM(1.0);
+    return DBL2NUM((double)loader_jobs_finished / loader_jobs_total);
+}
+
+static VALUE assets_is_loading(VALUE self)
+{
+    return loader_jobs_finished < loader_jobs_total ? Qtrue : Qfalse;
+}
+
+// blocks until every queued background load is decoded and uploaded, eg. at the end of a loading scene
+static VALUE assets_wait(VALUE self)
+{
+    while (loader_jobs_finished < loader_jobs_total)
+    {
+        rb_thread_call_without_gvl(loader_wait_for_any, NULL, NULL, NULL);
+        loader_process_completed(INFINITY);
+    }
+    return Qnil;
+}
+
+static VALUE assets_load_music(VALUE self, VALUE filename)
+{
+    Check_Type(filename, T_STRING);
+
+    VALUE cache_val = rb_iv_get(self, "@music");
+    Check_Type(cache_val, T_HASH);
+
+    VALUE music_val = rb_hash_lookup(cache_val, filename);
+    assert(rb_obj_is_kind_of(music_val, music_class));
+
+    if (music_val == Qnil)
+    {
+        // cache doesn't have an entry at this key, make a new one
+        double start = now_seconds();
+        RBMusic *music;
+        music_val = TypedData_Make_Struct(music_class, RBMusic, &music_type, music);
+        music->music = music_from_file(StringValueCStr(filename));
+        music->id = music_next_id++;
+        // only the stream's buffers are resident, the rest is decoded as it plays
+        asset_set_bytes(&music->info, 2 * MUSIC_BUFFER_FRAMES * music->music.stream.channels * (music->music.stream.sampleSize / 8));
+        asset_stats_record(start, StringValueCStr(filename));
+        // TODO: should raise error if music loading failed
+        asset_cache(cache_val, filename, music_val);
+    }
+    else
+    {
+        asset_use(music_val, true);
+    }
+
+    // if cache already has this entry, just return it
+    return music_val;
+}
+
+typedef struct
+{
+    FILE *file;
+    const char *path;
+    RBPackEntry *entries;
+    uint64_t offset; // where the next blob goes
+} RBPackWriter;
+
+static void pack_writer_fail(RBPackWriter *writer, const char *message, const char *asset)
+{
+    fclose(writer->file);
+    remove(writer->path);
+    ruby_xfree(writer->entries);
+    rb_raise(rb_eIOError, message, asset);
+}
+
+static void pack_writer_blob(RBPackWriter *writer, RBPackEntry *entry, const void *data, uint64_t size)
+{
+    static const char padding[PACK_ALIGN] = {0};
+    uint64_t aligned = (writer->offset + PACK_ALIGN - 1) & ~(uint64_t)(PACK_ALIGN - 1);
+    fwrite(padding, 1, aligned - writer->offset, writer->file);
+    fwrite(data, 1, size, writer->file);
+    entry->data_offset = aligned;
+    entry->data_size = size;
+    writer->offset = aligned + size;
+}
+
+static bool pack_writer_file(RBPackWriter *writer, RBPackEntry *entry, const char *path)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in)
+        return false;
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    char *data = ALLOC_N(char, size > 0 ? size : 1);
+    bool read = fread(data, 1, size, in) == (size_t)size;
+    fclose(in);
+    if (read)
+        pack_writer_blob(writer, entry, data, size);
+    ruby_xfree(data);
+    return read;
+}
+
+// decodes every image and sound once so loading them later is a lookup into the mapped file
+// sounds longer than stream_after seconds keep their encoded bytes, decoded music would be huge and can't be streamed
+static VALUE assets_write_pack(VALUE self, VALUE path, VALUE images, VALUE sounds, VALUE stream_after_val)
+{
+    Check_Type(path, T_STRING);
+    Check_Type(images, T_ARRAY);
+    Check_Type(sounds, T_ARRAY);
+    double stream_after = NUM2DBL(stream_after_val);
+
+    long image_count = RARRAY_LEN(images);
+    long count = image_count + RARRAY_LEN(sounds);
+    VALUE names = rb_str_buf_new(0);
+    for (long i = 0; i < count; i++)
+    {
+        VALUE name = i < image_count ? rb_ary_entry(images, i) : rb_ary_entry(sounds, i - image_count);
+        StringValueCStr(name);
+        rb_str_buf_append(names, name);
+        rb_str_buf_cat(names, "", 1);
+    }
+
+    RBPackWriter writer = {.path = StringValueCStr(path)};
+    writer.file = fopen(writer.path, "wb");
+    if (!writer.file)
+        rb_raise(rb_eIOError, "Failed to write %s", writer.path);
+
+    RBPackHeader header = {.magic = PACK_MAGIC, .version = PACK_VERSION, .entry_count = (uint32_t)count};
+    header.names_offset = sizeof(RBPackHeader) + count * sizeof(RBPackEntry);
+    header.names_size = RSTRING_LEN(names);
+    writer.entries = ZALLOC_N(RBPackEntry, count);
+    writer.offset = header.names_offset + header.names_size;
+
+    // the index is written last, once every blob's offset is known
+    fseek(writer.file, header.names_offset, SEEK_SET);
+    fwrite(RSTRING_PTR(names), 1, header.names_size, writer.file);
+
+    long streamed = 0;
+    uint32_t name_offset = 0;
+    for (long i = 0; i < count; i++)
+    {
+        const char *name = RSTRING_PTR(names) + name_offset;
+        RBPackEntry *entry = &writer.entries[i];
+        entry->name_offset = name_offset;
+        entry->name_length = (uint32_t)strlen(name);
+        name_offset += entry->name_length + 1;
+
+        if (i < image_count)
+        {
+            Image image = LoadImage(name);
+            if (!image.data)
+                pack_writer_fail(&writer, "Failed to load image %s", name);
+            entry->kind = PACK_IMAGE;
+            entry->params[0] = image.width;
+            entry->params[1] = image.height;
+            entry->params[2] = 1; // only the base level is written
+            entry->params[3] = image.format;
+            pack_writer_blob(&writer, entry, image.data, GetPixelDataSize(image.width, image.height, image.format));
+            UnloadImage(image);
+            continue;
+        }
+
+        Wave wave = LoadWave(name);
+        if (!wave.data)
+            pack_writer_fail(&writer, "Failed to load sound %s", name);
+        if (wave.sampleRate && (double)wave.frameCount / wave.sampleRate > stream_after)
+        {
+            UnloadWave(wave);
+            entry->kind = PACK_ENCODED;
+            if (!pack_writer_file(&writer, entry, name))
+                pack_writer_fail(&writer, "Failed to read %s", name);
+            streamed++;
+            continue;
+        }
+        entry->kind = PACK_WAVE;
+        entry->params[0] = wave.frameCount;
+        entry->params[1] = wave.sampleRate;
+        entry->params[2] = wave.sampleSize;
+        entry->params[3] = wave.channels;
+        pack_writer_blob(&writer, entry, wave.data, (uint64_t)wave.frameCount * wave.channels * (wave.sampleSize / 8));
+        UnloadWave(wave);
+    }
+
+    fseek(writer.file, 0, SEEK_SET);
+    fwrite(&header, sizeof(RBPackHeader), 1, writer.file);
+    fwrite(writer.entries, sizeof(RBPackEntry), count, writer.file);
+    bool failed = ferror(writer.file);
+    if (fclose(writer.file) != 0 || failed)
+    {
+        remove(writer.path);
+        ruby_xfree(writer.entries);
+        rb_raise(rb_eIOError, "Failed to write %s", writer.path);
+    }
+    ruby_xfree(writer.entries);
+    RB_GC_GUARD(names);
+
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("images")), LONG2NUM(image_count));
+    rb_hash_aset(stats, ID2SYM(rb_intern("sounds")), LONG2NUM(count - image_count - streamed));
+    rb_hash_aset(stats, ID2SYM(rb_intern("streamed")), LONG2NUM(streamed));
+    rb_hash_aset(stats, ID2SYM(rb_intern("bytes")), ULL2NUM(writer.offset));
+    return stats;
+}
+
+// bytes raylib reads from a decoded entry, 0 if its params make no sense
+static uint64_t pack_entry_expected_size(const RBPackEntry *entry)
+{
+    if (entry->kind == PACK_IMAGE)
+    {
+        int w = (int)entry->params[0], h = (int)entry->params[1];
+        if (w <= 0 || h <= 0 || entry->params[2] < 1)
+            return 0;
+        // every mip level is uploaded with the base image
+        uint64_t expected = 0;
+        for (uint32_t level = 0; level < entry->params[2]; level++)
+        {
+            int level_size = GetPixelDataSize(w, h, (int)entry->params[3]);
+            if (level_size <= 0)
+                return 0;
+            expected += (uint64_t)level_size;
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+        return expected;
+    }
+    if (entry->kind == PACK_WAVE)
+    {
+        uint32_t sample_size = entry->params[2];
+        if (entry->params[3] == 0 || (sample_size != 8 && sample_size != 16 && sample_size != 32))
+            return 0;
+        return (uint64_t)entry->params[0] * entry->params[3] * (sample_size / 8);
+    }
+    // encoded files are checked by their decoder
+    return entry->kind == PACK_ENCODED ? 1 : 0;
+}
+
+static bool pack_valid(const uint8_t *data, size_t size)
+{
+    const RBPackHeader *header = (const RBPackHeader *)data;
+    if (size < sizeof(RBPackHeader) || memcmp(header->magic, PACK_MAGIC, sizeof(header->magic)) != 0)
+        return false;
+    if (header->names_offset != sizeof(RBPackHeader) + (uint64_t)header->entry_count * sizeof(RBPackEntry) ||
+        header->names_size > size || header->names_offset > size - header->names_size)
+        return false;
+
+    const RBPackEntry *entries = (const RBPackEntry *)(data + sizeof(RBPackHeader));
+    const char *names = (const char *)data + header->names_offset;
+    for (uint32_t i = 0; i < header->entry_count; i++)
+    {
+        const RBPackEntry *entry = &entries[i];
+        if ((uint64_t)entry->name_offset + entry->name_length >= header->names_size ||
+            names[entry->name_offset + entry->name_length] != '\0')
+            return false;
+        if (entry->data_size > size || entry->data_offset > size - entry->data_size)
+            return false;
+        // a stale or truncated pack would have raylib read past the mapping
+        uint64_t expected = pack_entry_expected_size(entry);
+        if (expected == 0 || entry->data_size < expected)
+            return false;
+    }
+    return true;
+}
+
+// maps a pack so assets in it load without touching their loose files, anything not in it still loads from disk
+// the mapping stays for the rest of the process, music streams read from it and textures can be reloaded
+static VALUE assets_mount(VALUE self, VALUE path)
+{
+    Check_Type(path, T_STRING);
+    const char *filename = StringValueCStr(path);
+    if (asset_pack.data)
+        rb_raise(rb_eRuntimeError, "An asset pack is already mounted from %s", asset_pack.path);
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        rb_raise(rb_eIOError, "Failed to open asset pack %s", filename);
+    struct stat st;
+    void *data = fstat(fd, &st) == 0 && st.st_size > 0 ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED)
+        rb_raise(rb_eIOError, "Failed to map asset pack %s", filename);
+
+    const RBPackHeader *header = (const RBPackHeader *)data;
+    if (!pack_valid(data, st.st_size))
+    {
+        munmap(data, st.st_size);
+        rb_raise(rb_eIOError, "%s is not an asset pack", filename);
+    }
+    if (header->version != PACK_VERSION)
+    {
+        munmap(data, st.st_size);
+        rb_raise(rb_eIOError, "%s was packed by another version of rbscene, run `rbscene pack` again", filename);
+    }
+
+    // start reading the whole file in now, startup loads touch most of it
+    madvise(data, st.st_size, MADV_WILLNEED);
+
+    asset_pack = (RBPack){.path = ruby_strdup(filename), .data = data, .size = st.st_size};
+    asset_pack.entries = (const RBPackEntry *)(asset_pack.data + sizeof(RBPackHeader));
+    asset_pack.entry_count = header->entry_count;
+    asset_pack.index = st_init_strtable_with_size(header->entry_count);
+    const char *names = (const char *)asset_pack.data + header->names_offset;
+    for (uint32_t i = 0; i < header->entry_count; i++)
+        st_insert(asset_pack.index, (st_data_t)(names + asset_pack.entries[i].name_offset), i);
+
+    return Qnil;
+}
+
+static int asset_release_i(VALUE asset, VALUE value, VALUE arg)
+{
+    RBAssetInfo *info = asset_info(asset);
+    if (info->refs > 0)
+        info->refs--;
+    info->last_used = now_seconds();
+    return ST_CONTINUE;
+}
+
+// drops a scene's references to everything it loaded, assets nothing else uses become evictable
+static VALUE assets_release_scope(VALUE self, VALUE scope)
+{
+    Check_Type(scope, T_HASH);
+    rb_hash_foreach(scope, asset_release_i, Qnil);
+    rb_hash_clear(scope);
+    asset_trim(asset_budget);
+    return Qnil;
+}
+
+typedef struct
+{
+    VALUE list;
+    VALUE kind;
+} RBAssetListing;
+
+static int asset_list_i(VALUE path, VALUE asset, VALUE arg)
+{
+    RBAssetListing *listing = (RBAssetListing *)arg;
+    RBAssetInfo *info = asset_info(asset);
+    VALUE entry = rb_hash_new();
+    rb_hash_aset(entry, ID2SYM(rb_intern("path")), path);
+    rb_hash_aset(entry, ID2SYM(rb_intern("kind")), listing->kind);
+    rb_hash_aset(entry, ID2SYM(rb_intern("bytes")), SIZET2NUM(info->bytes));
+    rb_hash_aset(entry, ID2SYM(rb_intern("refs")), INT2NUM(info->refs));
+    rb_hash_aset(entry, ID2SYM(rb_intern("pinned")), info->pinned ? Qtrue : Qfalse);
+    rb_hash_aset(entry, ID2SYM(rb_intern("idle_s")), DBL2NUM(info->refs > 0 ? 0.0 : now_seconds() - info->last_used));
+    rb_ary_push(listing->list, entry);
+    return ST_CONTINUE;
+}
+
+static VALUE assets_cached_assets(VALUE self)
+{
+    static const char *caches[] = {"@textures", "@sounds", "@music"};
+    static const char *kinds[] = {"texture", "sound", "music"};
+    RBAssetListing listing = {.list = rb_ary_new()};
+    for (int i = 0; i < 3; i++)
+    {
+        listing.kind = ID2SYM(rb_intern(kinds[i]));
+        rb_hash_foreach(rb_iv_get(self, caches[i]), asset_list_i, (VALUE)&listing);
+    }
+    return listing.list;
+}
+
+static VALUE assets_cache_stats(VALUE self)
+{
+    long lookups = asset_stats_hits + asset_stats_loads;
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("cached_bytes")), SIZET2NUM(asset_cached_bytes));
+    rb_hash_aset(stats, ID2SYM(rb_intern("resident_bytes")), SIZET2NUM(asset_resident_bytes));
+    rb_hash_aset(stats, ID2SYM(rb_intern("budget")), asset_budget == SIZE_MAX ? Qnil : SIZET2NUM(asset_budget));
+    rb_hash_aset(stats, ID2SYM(rb_intern("hits")), LONG2NUM(asset_stats_hits));
+    rb_hash_aset(stats, ID2SYM(rb_intern("misses")), LONG2NUM(asset_stats_loads));
+    rb_hash_aset(stats, ID2SYM(rb_intern("hit_rate")), DBL2NUM(lookups ? (double)asset_stats_hits / lookups : 0.0));
+    rb_hash_aset(stats, ID2SYM(rb_intern("evicted")), LONG2NUM(asset_stats_evicted));
+    return stats;
+}
+
+static VALUE assets_load_stats(VALUE self)
+{
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("loads")), LONG2NUM(asset_stats_loads));
+    rb_hash_aset(stats, ID2SYM(rb_intern("from_pack")), LONG2NUM(asset_stats_packed));
+    rb_hash_aset(stats, ID2SYM(rb_intern("load_ms")), DBL2NUM(asset_stats_seconds * 1000.0));
+    rb_hash_aset(stats, ID2SYM(rb_intern("pack")), asset_pack.path ? rb_str_new_cstr(asset_pack.path) : Qnil);
+    rb_hash_aset(stats, ID2SYM(rb_intern("pack_entries")), UINT2NUM(asset_pack.entry_count));
+    return stats;
+}
+
+static void atlas_packer_free(void *ptr)
+{
+    RBAtlasPacker *packer = (RBAtlasPacker *)ptr;
+    for (int i = 0; i < packer->page_count; i++)
+        ruby_xfree(packer->pages[i].nodes);
+    ruby_xfree(packer->pages);
+    ruby_xfree(ptr);
+}
+
+static const rb_data_type_t atlas_packer_type =
+    {
+        "RBScene::AtlasPacker",
+        {0, atlas_packer_free, 0},
+        0,
+        0,
+        RUBY_TYPED_FREE_IMMEDIATELY};
+
+static void skyline_insert_node(RBSkylinePage *page, int index, RBSkylineNode node)
+{
+    if (page->node_count == page->node_capacity)
+    {
+        page->node_capacity = page->node_capacity ? page->node_capacity * 2 : 16;
+        REALLOC_N(page->nodes, RBSkylineNode, page->node_capacity);
+    }
+    memmove(&page->nodes[index + 1], &page->nodes[index], (page->node_count - index) * sizeof(RBSkylineNode));
+    page->nodes[index] = node;
+    page->node_count++;
+}
+
+static void skyline_remove_node(RBSkylinePage *page, int index)
+{
+    memmove(&page->nodes[index], &page->nodes[index + 1], (page->node_count - index - 1) * sizeof(RBSkylineNode));
+    page->node_count--;
+}
+
+// lowest y a w wide rect can sit at when its left edge is on node index, -1 if it doesn't fit
+static int skyline_fit(RBSkylinePage *page, int index, int w, int h)
+{
+    int x = page->nodes[index].x;
+    if (x + w > page->size)
+        return -1;
+
+    int y = 0;
+    int remaining = w;
+    for (int i = index; remaining > 0; i++)
+    {
+        if (i == page->node_count)
+            return -1;
+        if (page->nodes[i].y > y)
+            y = page->nodes[i].y;
+        if (y + h > page->size)
+            return -1;
+        remaining -= page->nodes[i].width;
+    }
+    return y;
+}
+
+// bottom left skyline packing, picks the position that keeps the skyline lowest, ties go to the narrowest node
+static bool skyline_insert(RBSkylinePage *page, int w, int h, int *out_x, int *out_y)
+{
+    int best_index = -1, best_y = INT_MAX, best_width = INT_MAX;
+    for (int i = 0; i < page->node_count; i++)
+    {
+        int y = skyline_fit(page, i, w, h);
+        if (y < 0)
+            continue;
+        if (y + h < best_y || (y + h == best_y && page->nodes[i].width < best_width))
+        {
+            best_index = i;
+            best_y = y + h;
+            best_width = page->nodes[i].width;
+        }
+    }
+
+    if (best_index < 0)
+        return false;
+
+    int x = page->nodes[best_index].x;
+    *out_x = x;
+    *out_y = best_y - h;
+    skyline_insert_node(page, best_index, (RBSkylineNode){.x = x, .y = best_y, .width = w});
+
+    // shrink or drop the nodes the new one now covers
+    for (int i = best_index + 1; i < page->node_count; i++)
+    {
+        RBSkylineNode *prev = &page->nodes[i - 1];
+        RBSkylineNode *node = &page->nodes[i];
+        if (node->x >= prev->x + prev->width)
+            break;
+
+        int shrink = prev->x + prev->width - node->x;
+        node->x += shrink;
+        node->width -= shrink;
+        if (node->width > 0)
+            break;
+        skyline_remove_node(page, i);
+        i--;
+    }
+
+    // merge neighbours at the same height
+    for (int i = 0; i < page->node_count - 1; i++)
+    {
+        if (page->nodes[i].y == page->nodes[i + 1].y)
+        {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            skyline_remove_node(page, i + 1);
+            i--;
+        }
+    }
+
+    page->used_area += (long long)w * h;
+    page->used_width = x + w > page->used_width ? x + w : page->used_width;
+    page->used_height = best_y > page->used_height ? best_y : page->used_height;
+    return true;
+}
+
+// pages are trimmed to the power of two that fits their contents, mostly matters for the last page
+static void skyline_page_trimmed_size(RBSkylinePage *page, int *out_w, int *out_h)
+{
+    int w = 1, h = 1;
+    while (w < page->used_width && w < page->size)
+        w *= 2;
+    while (h < page->used_height && h < page->size)
+        h *= 2;
+    *out_w = w > page->size ? page->size : w;
+    *out_h = h > page->size ? page->size : h;
+}
+
+static void atlas_packer_add_page(RBAtlasPacker *packer)
+{
+    if (packer->page_count == packer->page_capacity)
+    {
+        packer->page_capacity = packer->page_capacity ? packer->page_capacity * 2 : 4;
+        REALLOC_N(packer->pages, RBSkylinePage, packer->page_capacity);
+    }
+
+    RBSkylinePage *page = &packer->pages[packer->page_count++];
+    *page = (RBSkylinePage){.size = packer->page_size};
+    skyline_insert_node(page, 0, (RBSkylineNode){.x = 0, .y = 0, .width = packer->page_size});
+}
+
+// places a w by h rect, padding is added around it, returns false if it can never fit on a page
+static bool atlas_packer_insert(RBAtlasPacker *packer, int w, int h, int *out_page, int *out_x, int *out_y)
+{
+    int padded_w = w + packer->padding * 2;
+    int padded_h = h + packer->padding * 2;
+    if (padded_w > packer->page_size || padded_h > packer->page_size)
+        return false;
+
+    for (int i = 0;; i++)
+    {
+        if (i == packer->page_count)
+            atlas_packer_add_page(packer);
+
+        int x, y;
+        if (skyline_insert(&packer->pages[i], padded_w, padded_h, &x, &y))
+        {
+            *out_page = i;
+            *out_x = x + packer->padding;
+            *out_y = y + packer->padding;
+            return true;
+        }
+    }
+}
+
+static void atlas_packer_init(RBAtlasPacker *packer, VALUE page_size_val, VALUE padding_val)
+{
+    if (!rb_obj_is_kind_of(page_size_val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "page size is not a Numeric");
+    if (!rb_obj_is_kind_of(padding_val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "padding is not a Numeric");
+
+    packer->page_size = NUM2INT(page_size_val);
+    packer->padding = NUM2INT(padding_val);
+    if (packer->page_size <= 0 || packer->padding < 0)
+        rb_raise(rb_eArgError, "page size must be positive and padding can't be negative");
+}
+
+// fill ratio is over the trimmed pages, the texture memory an atlas built from this packer would take
+static VALUE atlas_packer_stats(RBAtlasPacker *packer)
+{
+    long long used = 0;
+    long long total = 0;
+    for (int i = 0; i < packer->page_count; i++)
+    {
+        int page_w, page_h;
+        skyline_page_trimmed_size(&packer->pages[i], &page_w, &page_h);
+        used += packer->pages[i].used_area;
+        total += (long long)page_w * page_h;
+    }
+
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("pages")), INT2NUM(packer->page_count));
+    rb_hash_aset(stats, ID2SYM(rb_intern("fill_ratio")), DBL2NUM(total ? (double)used / total : 0.0));
+    return stats;
+}
+
+static VALUE atlas_packer_alloc(VALUE self)
+{
+    RBAtlasPacker *packer;
+    return TypedData_Make_Struct(self, RBAtlasPacker, &atlas_packer_type, packer);
+}
+
+static VALUE atlas_packer_initialize(VALUE self, VALUE page_size_val, VALUE padding_val)
+{
+    RBAtlasPacker *packer;
+    TypedData_Get_Struct(self, RBAtlasPacker, &atlas_packer_type, packer);
+    atlas_packer_init(packer, page_size_val, padding_val);
+    return self;
+}
+
+// CPU only, returns [page, x, y]
+static VALUE atlas_packer_insert_method(VALUE self, VALUE w_val, VALUE h_val)
+{
+    RBAtlasPacker *packer;
+    TypedData_Get_Struct(self, RBAtlasPacker, &atlas_packer_type, packer);
+
+    int page, x, y;
+    if (!atlas_packer_insert(packer, NUM2INT(w_val), NUM2INT(h_val), &page, &x, &y))
+        rb_raise(rb_eArgError, "%dx%d doesn't fit on a %d page", NUM2INT(w_val), NUM2INT(h_val), packer->page_size);
+
+    return rb_ary_new_from_args(3, INT2NUM(page), INT2NUM(x), INT2NUM(y));
+}
+
+static VALUE atlas_packer_stats_method(VALUE self)
+{
+    RBAtlasPacker *packer;
+    TypedData_Get_Struct(self, RBAtlasPacker, &atlas_packer_type, packer);
+    return atlas_packer_stats(packer);
+}
+
+typedef struct
+{
+    Image image;
+    int index;
+    int page, x, y;
+} RBAtlasEntry;
+
+static int compare_atlas_entry_height(const void *a, const void *b)
+{
+    const RBAtlasEntry *ea = (const RBAtlasEntry *)a;
+    const RBAtlasEntry *eb = (const RBAtlasEntry *)b;
+    if (ea->image.height != eb->image.height)
+        return eb->image.height - ea->image.height;
+    return eb->image.width - ea->image.width;
+}
+
+// packs the images at paths into as few pages as possible and caches a region texture for each path
+// textures that were already loaded are turned into regions in place, so existing references keep working
+static VALUE assets_pack_atlas(VALUE self, VALUE paths, VALUE page_size_val, VALUE padding_val)
+{
+    Check_Type(paths, T_ARRAY);
+
+    VALUE cache_val = rb_iv_get(self, "@textures");
+    Check_Type(cache_val, T_HASH);
+
+    RBAtlasPacker *packer;
+    VALUE packer_val = TypedData_Make_Struct(atlas_packer_class, RBAtlasPacker, &atlas_packer_type, packer);
+    atlas_packer_init(packer, page_size_val, padding_val);
+
+    long count = RARRAY_LEN(paths);
+    if (count <= 0)
+        return rb_hash_new();
+    for (long i = 0; i < count; i++)
+        Check_Type(rb_ary_entry(paths, i), T_STRING);
+
+    RBAtlasEntry *entries = ALLOC_N(RBAtlasEntry, (size_t)count);
+    for (long i = 0; i < count; i++)
+    {
+        VALUE path = rb_ary_entry(paths, i);
+        entries[i] = (RBAtlasEntry){.index = i};
+        double start = now_seconds();
+        entries[i].image = image_from_file(StringValueCStr(path));
+        asset_stats_record(start, StringValueCStr(path));
+    }
+
+    for (long i = 0; i < count; i++)
+    {
+        if (entries[i].image.data == NULL)
+        {
+            VALUE path = rb_ary_entry(paths, i);
+            for (long j = 0; j < count; j++)
+                UnloadImage(entries[j].image);
+            ruby_xfree(entries);
+            rb_raise(rb_eIOError, "Failed to load image %s", StringValueCStr(path));
+        }
+    }
+
+    // tallest first packs noticeably tighter on a skyline
+    qsort(entries, count, sizeof(RBAtlasEntry), compare_atlas_entry_height);
+
+    for (long i = 0; i < count; i++)
+    {
+        if (!atlas_packer_insert(packer, entries[i].image.width, entries[i].image.height, &entries[i].page, &entries[i].x, &entries[i].y))
+        {
+            VALUE path = rb_ary_entry(paths, entries[i].index);
+            for (long j = 0; j < count; j++)
+                UnloadImage(entries[j].image);
+            ruby_xfree(entries);
+            rb_raise(rb_eArgError, "%s doesn't fit on a %d page", StringValueCStr(path), packer->page_size);
+        }
+    }
+
+    // compose every page on the CPU, then upload it once
+    VALUE pages = rb_ary_new();
+    long long total_area = 0;
+    for (int p = 0; p < packer->page_count; p++)
+    {
+        int page_w, page_h;
+        skyline_page_trimmed_size(&packer->pages[p], &page_w, &page_h);
+        total_area += (long long)page_w * page_h;
+
+        Image page_image = GenImageColor(page_w, page_h, BLANK);
+        for (long i = 0; i < count; i++)
+        {
+            if (entries[i].page != p)
+                continue;
+            Image image = entries[i].image;
+            ImageDraw(&page_image, image, (Rectangle){0, 0, image.width, image.height},
+                      (Rectangle){entries[i].x, entries[i].y, image.width, image.height}, WHITE);
+        }
+
+        RBTexture *page;
+        VALUE page_val = TypedData_Make_Struct(texture_class, RBTexture, &texture_type, page);
+        page->texture = texture_from_image(page_image);
+        page->region = (Rectangle){0, 0, page->texture.width, page->texture.height};
+        page->owned = true;
+        page->page = Qnil;
+        // pages aren't cached themselves, they stay resident while any of their regions is alive
+        asset_set_bytes(&page->info, texture_bytes(page->texture));
+        UnloadImage(page_image);
+        rb_ary_push(pages, page_val);
+    }
+
+    VALUE regions = rb_hash_new();
+    for (long i = 0; i < count; i++)
+    {
+        RBAtlasEntry entry = entries[i];
+        VALUE path = rb_ary_entry(paths, entry.index);
+        VALUE page_val = rb_ary_entry(pages, entry.page);
+        RBTexture *page;
+        TypedData_Get_Struct(page_val, RBTexture, &texture_type, page);
+
+        VALUE texture_val = rb_hash_lookup(cache_val, path);
+        RBTexture *tex;
+        bool cached = !NIL_P(texture_val);
+        if (!cached)
+        {
+            texture_val = TypedData_Make_Struct(texture_class, RBTexture, &texture_type, tex);
+        }
+        else
+        {
+            TypedData_Get_Struct(texture_val, RBTexture, &texture_type, tex);
+            if (tex->owned && tex->texture.id != 0)
+                UnloadTexture(tex->texture);
+            asset_set_bytes(&tex->info, 0);
+        }
+
+        tex->texture = page->texture;
+        texture_id_changes++;
+        tex->region = (Rectangle){entry.x, entry.y, entry.image.width, entry.image.height};
+        tex->owned = false;
+        RB_OBJ_WRITE(texture_val, &tex->page, page_val);
+        if (cached)
+            asset_use(texture_val, false);
+        else
+            asset_cache(cache_val, path, texture_val);
+
+        rb_hash_aset(regions, path, texture_val);
+        UnloadImage(entry.image);
+    }
+    ruby_xfree(entries);
+
+    atlas_stats_pages += packer->page_count;
+    for (int p = 0; p < packer->page_count; p++)
+        atlas_stats_used_area += packer->pages[p].used_area;
+    atlas_stats_total_area += total_area;
+    RB_GC_GUARD(packer_val);
+
+    return regions;
+}
+
+static VALUE assets_atlas_stats(VALUE self)
+{
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("pages")), INT2NUM(atlas_stats_pages));
+    rb_hash_aset(stats, ID2SYM(rb_intern("fill_ratio")),
+                 DBL2NUM(atlas_stats_total_area ? (double)atlas_stats_used_area / atlas_stats_total_area : 0.0));
+    return stats;
+}
+
+static VALUE texture_width(VALUE self)
+{
+    RBTexture *tex;
+    TypedData_Get_Struct(self, RBTexture, &texture_type, tex);
+    texture_ensure_loaded(tex);
+    return DBL2NUM(tex->region.width);
+}
+
+static VALUE texture_height(VALUE self)
+{
+    RBTexture *tex;
+    TypedData_Get_Struct(self, RBTexture, &texture_type, tex);
+    texture_ensure_loaded(tex);
+    return DBL2NUM(tex->region.height);
+}
+
+// false while a background load is still decoding or waiting for its upload
+static VALUE texture_is_loaded(VALUE self)
+{
+    RBTexture *tex;
+    TypedData_Get_Struct(self, RBTexture, &texture_type, tex);
+    return tex->job ? Qfalse : Qtrue;
+}
+
+static VALUE texture_is_atlas_region(VALUE self)
+{
+    RBTexture *tex;
+    TypedData_Get_Struct(self, RBTexture, &texture_type, tex);
+    return NIL_P(tex->page) ? Qfalse : Qtrue;
+}
+
+// playing the track that's already playing keeps it going and only changes its volume
+static VALUE music_start(VALUE self, VALUE volume, VALUE fade)
+{
+    RBMusic *music;
+    TypedData_Get_Struct(self, RBMusic, &music_type, music);
+    music_send((RBMusicCommand){.type = MUSIC_CMD_PLAY, .id = music->id, .music = music->music,
+                                .volume = (float)NUM2DBL(volume), .fade = (float)NUM2DBL(fade)});
+    if (self != music_playing)
+    {
+        music_fading = music_playing;
+        music_playing = self;
+    }
+    return Qnil;
+}
+
+static VALUE music_fade_out(VALUE self, VALUE fade)
+{
+    music_send((RBMusicCommand){.type = MUSIC_CMD_STOP, .fade = (float)NUM2DBL(fade)});
+    if (!NIL_P(music_playing))
+        music_fading = music_playing;
+    music_playing = Qnil;
+    return Qnil;
+}
+
+static VALUE music_set_volume(VALUE self, VALUE volume)
+{
+    music_send((RBMusicCommand){.type = MUSIC_CMD_VOLUME, .volume = (float)NUM2DBL(volume)});
+    return volume;
+}
+
+static int sound_idle_voice(RBSound *sound)
+{
+    for (int v = 0; v < sound->max_voices; v++)
+    {
+        if (sound->voice_started[v] == 0)
+            return v;
+    }
+    return -1;
+}
+
+// picks a voice for a new play: an idle one, then one that finished, then the sound's own oldest
+// returns -1 when the global cap is full of voices from higher priority sounds
+static int sound_claim_voice(RBSound *sound)
+{
+    int voice = sound_idle_voice(sound);
+    if (voice < 0)
+    {
+        audio_reap(sound);
+        voice = sound_idle_voice(sound);
+    }
+    if (voice < 0)
+    {
+        voice = 0;
+        for (int v = 1; v < sound->max_voices; v++)
+        {
+            if (sound->voice_started[v] < sound->voice_started[voice])
+                voice = v;
+        }
+        int index = voice_index(sound, voice);
+        if (index >= 0)
+            voice_stop(index);
+        audio_stats_stolen++;
+        return voice;
+    }
+
+    // an idle voice adds to the voices playing, so it has to fit under the global cap
+    if (active_voice_count >= max_active_voices)
+        audio_reap(NULL);
+    while (active_voice_count >= max_active_voices)
+    {
+        // lowest priority goes first, the oldest of those when there's a tie
+        int victim = 0;
+        for (int i = 1; i < active_voice_count; i++)
+        {
+            RBVoice a = active_voices[i], b = active_voices[victim];
+            if (a.sound->priority < b.sound->priority ||
+                (a.sound->priority == b.sound->priority && a.sound->voice_started[a.voice] < b.sound->voice_started[b.voice]))
+                victim = i;
+        }
+        if (active_voices[victim].sound->priority > sound->priority)
+            return -1;
+        voice_stop(victim);
+        audio_stats_stolen++;
+    }
+
+    // aliases are made in order, a voice past the last one is always the next to make
+    if (voice > sound->alias_count)
+    {
+        sound->aliases[sound->alias_count] = LoadSoundAlias(sound->sound);
+        voice = ++sound->alias_count;
+    }
+    return voice;
+}
+
+// play(volume = 1.0, pitch = 1.0, pan = 0.5), positional so a play allocates nothing
+// overlaps earlier plays up to max_voices, returns false when the play was dropped
+static VALUE sound_play(int argc, VALUE *argv, VALUE self)
+{
+    VALUE volume_val, pitch_val, pan_val;
+    rb_scan_args(argc, argv, "03", &volume_val, &pitch_val, &pan_val);
+
+    RBSound *sound;
+    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
+    sound_ensure_loaded(sound);
+    if (!sound->sound.stream.buffer)
+        return Qfalse;
+
+    int voice = sound_claim_voice(sound);
+    if (voice < 0)
+    {
+        audio_stats_dropped++;
+        return Qfalse;
+    }
+
+    Sound *playing = sound_voice(sound, voice);
+    SetSoundVolume(*playing, NIL_P(volume_val) ? 1.0f : (float)NUM2DBL(volume_val));
+    SetSoundPitch(*playing, NIL_P(pitch_val) ? 1.0f : (float)NUM2DBL(pitch_val));
+    SetSoundPan(*playing, NIL_P(pan_val) ? 0.5f : (float)NUM2DBL(pan_val));
+    PlaySound(*playing);
+
+    sound->voice_started[voice] = now_seconds();
+    active_voices[active_voice_count++] = (RBVoice){sound, voice};
+    audio_stats_played++;
+    return Qtrue;
+}
+
+static VALUE sound_stop(VALUE self)
+{
+    RBSound *sound;
+    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
+    sound_stop_voices(sound);
+    return Qnil;
+}
+
+static VALUE sound_is_loaded(VALUE self)
+{
+    RBSound *sound;
+    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
+    return sound->job ? Qfalse : Qtrue;
+}
+
+static VALUE sound_voices(VALUE self)
+{
+    RBSound *sound;
+    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
+    audio_reap(sound);
+    int count = 0;
+    for (int v = 0; v < SOUND_MAX_VOICES; v++)
+        count += sound->voice_started[v] != 0;
+    return INT2NUM(count);
+}
+
+static VALUE sound_max_voices(VALUE self)
+{
+    RBSound *sound;
+    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
+    return INT2NUM(sound->max_voices);
+}
+
+// voices past a lowered maximum finish what they're playing but aren't used again
+static VALUE sound_set_max_voices(VALUE self, VALUE count_val)
+{
+    RBSound *sound;
+    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
+    int count = NUM2INT(count_val);
+    if (count < 1 || count > SOUND_MAX_VOICES)
+        rb_raise(rb_eArgError, "max_voices must be between 1 and %d", SOUND_MAX_VOICES);
+    sound->max_voices = count;
+    return count_val;
+}
+
+static VALUE sound_priority(VALUE self)
+{
+    RBSound *sound;
+    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
+    return INT2NUM(sound->priority);
+}
+
+static VALUE sound_set_priority(VALUE self, VALUE priority_val)
+{
+    RBSound *sound;
+    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
+    sound->priority = NUM2INT(priority_val);
+    return priority_val;
+}
+
+// cap on voices playing across every sound, past it new plays steal from lower or equal priority sounds
+static VALUE sound_s_max_voices(VALUE self)
+{
+    return INT2NUM(max_active_voices);
+}
+
+static VALUE sound_s_set_max_voices(VALUE self, VALUE count_val)
+{
+    int count = NUM2INT(count_val);
+    if (count < 1 || count > AUDIO_VOICE_LIMIT)
+        rb_raise(rb_eArgError, "Sound.max_voices must be between 1 and %d", AUDIO_VOICE_LIMIT);
+    max_active_voices = count;
+    return count_val;
+}
+
+static VALUE emitter_alloc(VALUE self)
+{
+    RBEmitter *emitter;
+    VALUE obj = TypedData_Make_Struct(self, RBEmitter, &emitter_type, emitter);
+    emitter->texture = Qnil;
+    emitter->emitting = true;
+    emitter->lifetime = (RBRange){1, 1};
+    emitter->size_range = (RBRange){4, 4};
+    emitter->start_color = WHITE;
+    emitter->end_color = WHITE;
+    emitter->rng = 0x9e3779b9;
+    return obj;
+}
+
+// grows or shrinks particle storage, particles past the new capacity are dropped
+static VALUE emitter_set_max_particles(VALUE self, VALUE max_val)
+{
+    RBEmitter *emitter = get_emitter(self);
+    int capacity = NUM2INT(max_val);
+    if (capacity < 0)
+        rb_raise(rb_eArgError, "max_particles can't be negative");
+
+    REALLOC_N(emitter->x, float, capacity);
+    REALLOC_N(emitter->y, float, capacity);
+    REALLOC_N(emitter->vx, float, capacity);
+    REALLOC_N(emitter->vy, float, capacity);
+    REALLOC_N(emitter->life, float, capacity);
+    REALLOC_N(emitter->inv_lifetime, float, capacity);
+    REALLOC_N(emitter->size, float, capacity);
+    REALLOC_N(emitter->frame, unsigned short, capacity);
+    emitter->capacity = capacity;
+    if (emitter->count > capacity)
+        emitter->count = capacity;
+    return max_val;
+}
+
+static VALUE emitter_max_particles(VALUE self)
+{
+    return INT2NUM(get_emitter(self)->capacity);
+}
+
+static VALUE emitter_count(VALUE self)
+{
+    return INT2NUM(get_emitter(self)->count);
+}
+
+static VALUE emitter_x_getter(VALUE self)
+{
+    return DBL2NUM(get_emitter(self)->spawn_x);
+}
+
+static VALUE emitter_y_getter(VALUE self)
+{
+    return DBL2NUM(get_emitter(self)->spawn_y);
+}
+
+static VALUE emitter_x_setter(VALUE self, VALUE val)
+{
+    get_emitter(self)->spawn_x = NUM2DBL(val);
+    return val;
+}
+
+static VALUE emitter_y_setter(VALUE self, VALUE val)
+{
+    get_emitter(self)->spawn_y = NUM2DBL(val);
+    return val;
+}
+
+static VALUE emitter_move_to(VALUE self, VALUE x_val, VALUE y_val)
+{
+    RBEmitter *emitter = get_emitter(self);
+    emitter->spawn_x = NUM2DBL(x_val);
+    emitter->spawn_y = NUM2DBL(y_val);
+    return self;
+}
+
+static VALUE emitter_rate_getter(VALUE self)
+{
+    return DBL2NUM(get_emitter(self)->rate);
+}
+
+static VALUE emitter_rate_setter(VALUE self, VALUE val)
+{
+    float rate = NUM2DBL(val);
+    if (rate < 0)
+        rb_raise(rb_eArgError, "rate can't be negative");
+    get_emitter(self)->rate = rate;
+    return val;
+}
+
+static VALUE emitter_gravity_getter(VALUE self)
+{
+    return vector2_new(get_emitter(self)->gravity);
+}
+
+static VALUE emitter_gravity_setter(VALUE self, VALUE val)
+{
+    get_emitter(self)->gravity = vector2_value(val);
+    return val;
+}
+
+static VALUE emitter_is_emitting(VALUE self)
+{
+    return get_emitter(self)->emitting ? Qtrue : Qfalse;
+}
+
+static VALUE emitter_start(VALUE self)
+{
+    get_emitter(self)->emitting = true;
+    return Qnil;
+}
+
+// stops spawning, particles already out live out their lifetime
+static VALUE emitter_stop(VALUE self)
+{
+    RBEmitter *emitter = get_emitter(self);
+    emitter->emitting = false;
+    emitter->spawn_debt = 0;
+    return Qnil;
+}
+
+static VALUE emitter_burst(VALUE self, VALUE n_val)
+{
+    int n = NUM2INT(n_val);
+    if (n > 0)
+        emitter_spawn(get_emitter(self), n);
+    return Qnil;
+}
+
+static VALUE emitter_clear(VALUE self)
+{
+    get_emitter(self)->count = 0;
+    return Qnil;
+}
+
+static VALUE emitter_set_seed(VALUE self, VALUE seed_val)
+{
+    // xorshift gets stuck on 0
+    uint32_t seed = NUM2UINT(seed_val);
+    get_emitter(self)->rng = seed ? seed : 0x9e3779b9;
+    return seed_val;
+}
+
+// private, Ruby turns Numerics and Ranges into a min and max
+static VALUE emitter_set_range(VALUE self, VALUE name, VALUE min_val, VALUE max_val)
+{
+    RBEmitter *emitter = get_emitter(self);
+    RBRange range = {NUM2DBL(min_val), NUM2DBL(max_val)};
+
+    ID id = SYM2ID(name);
+    if (id == rb_intern("lifetime"))
+        emitter->lifetime = range;
+    else if (id == rb_intern("velocity_x"))
+        emitter->velocity_x = range;
+    else if (id == rb_intern("velocity_y"))
+        emitter->velocity_y = range;
+    else if (id == rb_intern("size"))
+        emitter->size_range = range;
+    else
+        rb_raise(rb_eArgError, "Unknown emitter range :%s", rb_id2name(id));
+    return Qnil;
+}
+
+// private, size of the area particles spawn in
+static VALUE emitter_set_area(VALUE self, VALUE width_val, VALUE height_val)
+{
+    RBEmitter *emitter = get_emitter(self);
+    emitter->spawn_width = NUM2DBL(width_val);
+    emitter->spawn_height = NUM2DBL(height_val);
+    return Qnil;
+}
+
+static Color color_value(VALUE val)
+{
+    Check_Type(val, T_ARRAY);
+    if (RARRAY_LEN(val) != 3 && RARRAY_LEN(val) != 4)
+        rb_raise(rb_eArgError, "Colors are [r, g, b] or [r, g, b, a] arrays");
+
+    return (Color){
+        .r = NUM2UINT(rb_ary_entry(val, 0)),
+        .g = NUM2UINT(rb_ary_entry(val, 1)),
+        .b = NUM2UINT(rb_ary_entry(val, 2)),
+        .a = RARRAY_LEN(val) == 4 ? NUM2UINT(rb_ary_entry(val, 3)) : 255};
+}
+
+// private, particles blend from the first color to the second over their life
+static VALUE emitter_set_colors(VALUE self, VALUE start_val, VALUE end_val)
+{
+    RBEmitter *emitter = get_emitter(self);
+    emitter->start_color = color_value(start_val);
+    emitter->end_color = color_value(end_val);
+    return Qnil;
+}
+
+// private, frames are Rects relative to the texture, each particle gets a random one
+static VALUE emitter_set_texture(VALUE self, VALUE texture, VALUE frames)
+{
+    RBEmitter *emitter = get_emitter(self);
+    Check_Type(frames, T_ARRAY);
+    if (RARRAY_LEN(frames) > USHRT_MAX)
+        rb_raise(rb_eArgError, "Emitters support at most %d frames", USHRT_MAX);
+
+    if (!NIL_P(texture))
+    {
+        if (!rb_obj_is_kind_of(texture, texture_class))
+            rb_raise(rb_eTypeError, "Emitter texture must be a Texture");
+
+        RBTexture *tex;
+        TypedData_Get_Struct(texture, RBTexture, &texture_type, tex);
+        texture_ensure_loaded(tex);
+    }
+
+    int frame_count = RARRAY_LEN(frames);
+    Rectangle *rects = ALLOC_N(Rectangle, frame_count ? frame_count : 1);
+    for (int i = 0; i < frame_count; i++)
+    {
+        VALUE frame = RARRAY_AREF(frames, i);
+        if (!rb_obj_is_kind_of(frame, rect_class))
+        {
+            xfree(rects);
+            rb_raise(rb_eTypeError, "Emitter frames must be Rects");
+        }
+        rects[i] = *get_rect(frame);
+    }
+
+    xfree(emitter->frames);
+    emitter->frames = rects;
+    emitter->frame_count = frame_count;
+    emitter->texture = texture;
+
+    // particles already out may point past the new frames
+    for (int i = 0; i < emitter->count; i++)
+        if (emitter->frame[i] >= frame_count)
+            emitter->frame[i] = 0;
+    return Qnil;
+}
+
+static VALUE tilemap_alloc(VALUE self)
+{
+    RBTilemap *map;
+    VALUE obj = TypedData_Make_Struct(self, RBTilemap, &tilemap_type, map);
+    map->tileset = Qnil;
+    return obj;
+}
+
+// private, sizes the grid and cuts the tileset into tiles, every tile starts empty
+static VALUE tilemap_setup(VALUE self, VALUE cols_val, VALUE rows_val, VALUE tile_width_val, VALUE tile_height_val, VALUE tileset)
+{
+    RBTilemap *map = get_tilemap(self);
+    int cols = NUM2INT(cols_val), rows = NUM2INT(rows_val);
+    int tile_width = NUM2INT(tile_width_val), tile_height = NUM2INT(tile_height_val);
+
+    if (cols < 0 || rows < 0)
+        rb_raise(rb_eArgError, "Tilemap size can't be negative");
+    if (tile_width <= 0 || tile_height <= 0)
+        rb_raise(rb_eArgError, "Tile size must be greater than 0");
+    if (!rb_obj_is_kind_of(tileset, texture_class))
+        rb_raise(rb_eTypeError, "Tileset must be a Texture");
+
+    RBTexture *tex;
+    TypedData_Get_Struct(tileset, RBTexture, &texture_type, tex);
+    texture_ensure_loaded(tex);
+
+    tilemap_free_chunks(map);
+    map->cols = cols;
+    map->rows = rows;
+    map->tile_width = tile_width;
+    map->tile_height = tile_height;
+    map->tileset = tileset;
+    map->tileset_cols = (int)(tex->region.width / tile_width);
+    map->tile_count = map->tileset_cols * (int)(tex->region.height / tile_height);
+
+    REALLOC_N(map->tiles, int, cols * rows);
+    for (int i = 0; i < cols * rows; i++)
+        map->tiles[i] = -1;
+
+    map->chunk_cols = (cols + TILEMAP_CHUNK_TILES - 1) / TILEMAP_CHUNK_TILES;
+    map->chunk_rows = (rows + TILEMAP_CHUNK_TILES - 1) / TILEMAP_CHUNK_TILES;
+    map->chunks = ZALLOC_N(RBTileChunk, map->chunk_cols * map->chunk_rows);
+    for (int i = 0; i < map->chunk_cols * map->chunk_rows; i++)
+        map->chunks[i].dirty = true;
+    return Qnil;
+}
+
+// private, replaces every tile from a flat row major array
+static VALUE tilemap_load_tiles(VALUE self, VALUE tiles)
+{
+    RBTilemap *map = get_tilemap(self);
+    Check_Type(tiles, T_ARRAY);
+    if (RARRAY_LEN(tiles) != map->cols * map->rows)
+        rb_raise(rb_eArgError, "Expected %d tiles, got %ld", map->cols * map->rows, RARRAY_LEN(tiles));
+
+    for (int i = 0; i < map->cols * map->rows; i++)
+        map->tiles[i] = NUM2INT(RARRAY_AREF(tiles, i));
+    for (int i = 0; i < map->chunk_cols * map->chunk_rows; i++)
+        map->chunks[i].dirty = true;
+    return Qnil;
+}
+
+static void tilemap_check_cell(RBTilemap *map, int col, int row)
+{
+    if (col < 0 || col >= map->cols || row < 0 || row >= map->rows)
+        rb_raise(rb_eIndexError, "Tile (%d, %d) is outside the %dx%d map", col, row, map->cols, map->rows);
+}
+
+static VALUE tilemap_get(VALUE self, VALUE col_val, VALUE row_val)
+{
+    RBTilemap *map = get_tilemap(self);
+    int col = NUM2INT(col_val), row = NUM2INT(row_val);
+    tilemap_check_cell(map, col, row);
+    return INT2NUM(map->tiles[row * map->cols + col]);
+}
+
+// only the chunk holding the tile is rendered again
+static VALUE tilemap_set(VALUE self, VALUE col_val, VALUE row_val, VALUE id_val)
+{
+    RBTilemap *map = get_tilemap(self);
+    int col = NUM2INT(col_val), row = NUM2INT(row_val), id = NUM2INT(id_val);
+    tilemap_check_cell(map, col, row);
+
+    int *tile = &map->tiles[row * map->cols + col];
+    if (*tile != id)
+    {
+        *tile = id;
+        map->chunks[(row / TILEMAP_CHUNK_TILES) * map->chunk_cols + col / TILEMAP_CHUNK_TILES].dirty = true;
+    }
+    return id_val;
+}
+
+static VALUE tilemap_cols(VALUE self)
+{
+    return INT2NUM(get_tilemap(self)->cols);
+}
+
+static VALUE tilemap_rows(VALUE self)
+{
+    return INT2NUM(get_tilemap(self)->rows);
+}
+
+static VALUE tilemap_tile_width(VALUE self)
+{
+    return INT2NUM(get_tilemap(self)->tile_width);
+}
+
+static VALUE tilemap_tile_height(VALUE self)
+{
+    return INT2NUM(get_tilemap(self)->tile_height);
+}
+
+static VALUE tilemap_x_getter(VALUE self)
+{
+    return DBL2NUM(get_tilemap(self)->x);
+}
+
+static VALUE tilemap_y_getter(VALUE self)
+{
+    return DBL2NUM(get_tilemap(self)->y);
+}
+
+// chunks are drawn relative to the map, so moving it doesn't render anything again
+static VALUE tilemap_move_to(VALUE self, VALUE x_val, VALUE y_val)
+{
+    RBTilemap *map = get_tilemap(self);
+    map->x = NUM2DBL(x_val);
+    map->y = NUM2DBL(y_val);
+    return self;
+}
+
+static VALUE tilemap_set_solid_tiles(VALUE self, VALUE ids)
+{
+    RBTilemap *map = get_tilemap(self);
+    Check_Type(ids, T_ARRAY);
+
+    int count = 0;
+    for (long i = 0; i < RARRAY_LEN(ids); i++)
+    {
+        int id = NUM2INT(RARRAY_AREF(ids, i));
+        if (id < 0)
+            rb_raise(rb_eArgError, "Tile ids can't be negative");
+        if (id + 1 > count)
+            count = id + 1;
+    }
+
+    REALLOC_N(map->solid, bool, count);
+    memset(map->solid, 0, count * sizeof(bool));
+    for (long i = 0; i < RARRAY_LEN(ids); i++)
+        map->solid[NUM2INT(RARRAY_AREF(ids, i))] = true;
+    map->solid_count = count;
+    return ids;
+}
+
+static VALUE tilemap_solid_at(VALUE self, VALUE x_val, VALUE y_val)
+{
+    RBTilemap *map = get_tilemap(self);
+    float col = floorf((NUM2DBL(x_val) - map->x) / map->tile_width);
+    float row = floorf((NUM2DBL(y_val) - map->y) / map->tile_height);
+    if (col < 0 || col >= map->cols || row < 0 || row >= map->rows)
+        return Qfalse;
+    return tilemap_solid_tile(map, (int)col, (int)row) ? Qtrue : Qfalse;
+}
+
+// whether any solid tile overlaps a world space Rect, only the tiles under it are checked
+static VALUE tilemap_solid_in(VALUE self, VALUE rect_val)
+{
+    RBTilemap *map = get_tilemap(self);
+    if (!rb_obj_is_kind_of(rect_val, rect_class))
+        rb_raise(rb_eTypeError, "Expected a Rect");
+
+    RBCellRange range = tilemap_range(map, *get_rect(rect_val));
+    for (int row = range.y0; row <= range.y1; row++)
+    {
+        for (int col = range.x0; col <= range.x1; col++)
+        {
+            if (tilemap_solid_tile(map, col, row))
+                return Qtrue;
+        }
+    }
+    return Qfalse;
+}
+
+// creates default render props with internally on game object, called on init
+// width and height defaults to the passed texture's width and height, everything else is zero
+static VALUE game_object_make_render_props(VALUE self, VALUE texture)
+{
+    assert(rb_obj_is_kind_of(texture, texture_class));
+
+    RBRenderProps *robj;
+    VALUE robj_val = TypedData_Make_Struct(render_props_class, RBRenderProps, &render_props_type, robj);
+
+    RBTexture *tex;
+    TypedData_Get_Struct(texture, RBTexture, &texture_type, tex);
+    texture_ensure_loaded(tex);
+
+    int slot = render_pool_alloc();
+    robj->slot = slot;
+    robj->texture = texture;
+
+    render_pool.texture[slot] = tex;
+    render_pool.x[slot] = 0;
+    render_pool.y[slot] = 0;
+    render_pool.width[slot] = tex->region.width;
+    render_pool.height[slot] = tex->region.height;
+    render_pool.angle[slot] = 0;
+    render_pool.frame[slot] = (Rectangle){
+        .x = 0,
+        .y = 0,
+        .width = tex->region.width,
+        .height = tex->region.height,
+    };
+    render_pool.hflip[slot] = false;
+    render_pool.vflip[slot] = false;
+    render_pool.origin_x[slot] = 0;
+    render_pool.origin_y[slot] = 0;
+    render_pool.layer[slot] = 0;
+    render_pool.z[slot] = 0;
+    render_pool.is_static[slot] = false;
+
+    return robj_val;
+}
+
+static VALUE render_props_x_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return DBL2NUM(render_pool.x[props->slot]);
+}
+
+static VALUE render_props_y_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return DBL2NUM(render_pool.y[props->slot]);
+}
+
+static VALUE render_props_width_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return DBL2NUM(render_pool.width[props->slot]);
+}
+
+static VALUE render_props_height_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return DBL2NUM(render_pool.height[props->slot]);
+}
+
+static VALUE render_props_angle_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return DBL2NUM(render_pool.angle[props->slot]);
+}
+
+// frame(out = nil), copies into out when given so polling the frame doesn't allocate
+static VALUE render_props_frame_getter(int argc, VALUE *argv, VALUE self)
+{
+    VALUE out;
+    rb_scan_args(argc, argv, "01", &out);
+
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+
+    if (!NIL_P(out))
+    {
+        if (!rb_obj_is_kind_of(out, rect_class))
+            rb_raise(rb_eTypeError, "frame can only be copied into a Rect");
+        *get_rect(out) = render_pool.frame[props->slot];
+        return out;
+    }
+
+    Rectangle *rect;
+    VALUE rect_val = TypedData_Make_Struct(rect_class, Rectangle, &rect_type, rect);
+    *rect = render_pool.frame[props->slot];
+    return rect_val;
+}
+
+static VALUE render_props_position(int argc, VALUE *argv, VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return vector2_out(argc, argv, (Vector2){render_pool.x[props->slot], render_pool.y[props->slot]});
+}
+
+static VALUE render_props_size(int argc, VALUE *argv, VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return vector2_out(argc, argv, (Vector2){render_pool.width[props->slot], render_pool.height[props->slot]});
+}
+
+static VALUE render_props_hflip_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return render_pool.hflip[props->slot] ? Qtrue : Qfalse;
+}
+
+static VALUE render_props_vflip_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return render_pool.vflip[props->slot] ? Qtrue : Qfalse;
+}
+
+static VALUE render_props_origin_x_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return DBL2NUM(render_pool.origin_x[props->slot]);
+}
+
+static VALUE render_props_origin_y_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return DBL2NUM(render_pool.origin_y[props->slot]);
+}
+
+static VALUE render_props_layer_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return INT2NUM(render_pool.layer[props->slot]);
+}
+
+static VALUE render_props_z_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return DBL2NUM(render_pool.z[props->slot]);
+}
+
+// the owning list sorts itself again before its next draw
+static void render_pool_reorder(int slot)
+{
+    if (render_pool.owner[slot])
+        render_pool.owner[slot]->unsorted++;
+}
+
+static VALUE render_props_layer_setter(VALUE self, VALUE val)
+{
+    if (!RB_INTEGER_TYPE_P(val))
+        rb_raise(rb_eTypeError, "layer is not an Integer");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+
+    int layer = NUM2INT(val);
+    if (render_pool.layer[props->slot] != layer)
+    {
+        static_cache_mark(props->slot);
+        render_pool.layer[props->slot] = layer;
+        static_cache_mark(props->slot);
+        render_pool_reorder(props->slot);
+    }
+    return self;
+}
+
+static VALUE render_props_z_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "z is not a Numeric");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+
+    float z = NUM2DBL(val);
+    if (render_pool.z[props->slot] != z)
+    {
+        render_pool.z[props->slot] = z;
+        static_cache_mark(props->slot);
+        render_pool_reorder(props->slot);
+    }
+    return self;
+}
+
+static VALUE render_props_static_getter(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    return render_pool.is_static[props->slot] ? Qtrue : Qfalse;
+}
+
+static VALUE render_props_static_setter(VALUE self, VALUE val)
+{
+    if (val != Qtrue && val != Qfalse)
+        rb_raise(rb_eTypeError, "static is not a Boolean");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+
+    if (render_pool.is_static[props->slot] != (val == Qtrue))
+    {
+        static_cache_mark(props->slot);
+        render_pool.is_static[props->slot] = val == Qtrue;
+        static_cache_mark(props->slot);
+    }
+    return self;
+}
+
+static VALUE render_props_x_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "x is not a Numeric");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.x[props->slot] = NUM2DBL(val);
+    render_pool_touch(props->slot);
+    return self;
+}
+
+static VALUE render_props_y_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "y is not a Numeric");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.y[props->slot] = NUM2DBL(val);
+    render_pool_touch(props->slot);
+    return self;
+}
+
+static VALUE render_props_width_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "width is not a Numeric");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.width[props->slot] = NUM2DBL(val);
+    render_pool_touch(props->slot);
+    return self;
+}
+
+static VALUE render_props_height_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "height is not a Numeric");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.height[props->slot] = NUM2DBL(val);
+    render_pool_touch(props->slot);
+    return self;
+}
+
+static VALUE render_props_angle_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "angle is not a Numeric");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.angle[props->slot] = NUM2DBL(val);
+    render_pool_touch(props->slot);
+    return self;
+}
+
+// makes the current position the previous one too, so the next draw doesn't interpolate across a jump
+static VALUE render_props_snap(VALUE self)
+{
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.prev_x[props->slot] = render_pool.x[props->slot];
+    render_pool.prev_y[props->slot] = render_pool.y[props->slot];
+    return self;
+}
+
+static VALUE render_props_frame_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rect_class))
+        rb_raise(rb_eTypeError, "frame is not a Rect");
+
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+
+    Rectangle *rect;
+    TypedData_Get_Struct(val, Rectangle, &rect_type, rect);
+
+    render_pool.frame[props->slot] = *rect;
+    static_cache_mark(props->slot);
+    return self;
+}
+
+static VALUE render_props_hflip_setter(VALUE self, VALUE val)
+{
+    if (val != Qtrue && val != Qfalse)
+        rb_raise(rb_eTypeError, "hflip is not a Boolean");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.hflip[props->slot] = val == Qtrue;
+    static_cache_mark(props->slot);
+    return self;
+}
+
+static VALUE render_props_vflip_setter(VALUE self, VALUE val)
+{
+    if (val != Qtrue && val != Qfalse)
+        rb_raise(rb_eTypeError, "vflip is not a Boolean");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.vflip[props->slot] = val == Qtrue;
+    static_cache_mark(props->slot);
+    return self;
+}
+
+static VALUE render_props_origin_x_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "x origin is not a Numeric");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.origin_x[props->slot] = NUM2DBL(val);
+    render_pool_touch(props->slot);
+    return self;
+}
+
+static VALUE render_props_origin_y_setter(VALUE self, VALUE val)
+{
+    if (!rb_obj_is_kind_of(val, rb_cNumeric))
+        rb_raise(rb_eTypeError, "y origin is not a Numeric");
+    RBRenderProps *props;
+    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+    render_pool.origin_y[props->slot] = NUM2DBL(val);
+    render_pool_touch(props->slot);
+    return self;
+}
+
+static VALUE draw_list_alloc(VALUE self)
+{
+    RBDrawList *list;
+    return TypedData_Make_Struct(self, RBDrawList, &draw_list_type, list);
+}
+
+// returns the render pool slot of a game object, or -1 if it has nothing to draw
+static int game_object_render_slot(VALUE obj)
+{
+    if (!rb_obj_is_kind_of(obj, game_object_class))
+    {
+        VALUE class_name = rb_class_name(rb_obj_class(obj));
+        rb_raise(rb_eTypeError, "Attempting to draw a %s, which is not a GameObject", StringValueCStr(class_name));
+    }
+
+    VALUE render_props_val = rb_iv_get(obj, "@render_props");
+    if (NIL_P(render_props_val))
+        return -1;
+
+    RBRenderProps *props;
+    TypedData_Get_Struct(render_props_val, RBRenderProps, &render_props_type, props);
+    return props->slot;
+}
+
+static VALUE draw_list_initialize(int argc, VALUE *argv, VALUE self)
+{
+    VALUE cell_size_val;
+    rb_scan_args(argc, argv, "01", &cell_size_val);
+
+    RBDrawList *list;
+    TypedData_Get_Struct(self, RBDrawList, &draw_list_type, list);
+
+    // lists without a cell size are never spatially indexed, they get culled with a linear scan
+    if (!NIL_P(cell_size_val))
+    {
+        if (!rb_obj_is_kind_of(cell_size_val, rb_cNumeric))
+            rb_raise(rb_eTypeError, "cell size is not a Numeric");
+
+        float cell_size = NUM2DBL(cell_size_val);
+        if (cell_size <= 0)
+            rb_raise(rb_eArgError, "cell size must be greater than zero");
+
+        list->grid = grid_new(cell_size);
+    }
+
+    return self;
+}
+
+static VALUE draw_list_add(VALUE self, VALUE obj)
+{
+    int slot = game_object_render_slot(obj);
+    if (slot < 0)
+        return self;
+
+    RBDrawList *list;
+    TypedData_Get_Struct(self, RBDrawList, &draw_list_type, list);
+
+    if (list->count == list->capacity && list->holes > list->count / 2)
+        draw_list_compact(list);
+    if (list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        REALLOC_N(list->slots, int, list->capacity);
+    }
+    render_pool.list_index[slot] = list->count;
+    list->slots[list->count++] = slot;
+
+    render_pool.owner[slot] = list;
+    render_pool.seq[slot] = list->next_seq++;
+    list->unsorted++;
+    static_cache_mark(slot);
+    render_pool.bounds[slot] = render_pool_compute_bounds(slot);
+    if (list->grid)
+        grid_insert(list->grid, slot);
+
+    return self;
+}
+
+static VALUE draw_list_remove(VALUE self, VALUE obj)
+{
+    int slot = game_object_render_slot(obj);
+    if (slot < 0)
+        return self;
+
+    RBDrawList *list;
+    TypedData_Get_Struct(self, RBDrawList, &draw_list_type, list);
+    if (render_pool.owner[slot] != list)
+        return self;
+
+    static_cache_mark(slot);
+
+    // leave a hole, compacting later keeps draw order intact without shifting on every removal
+    list->slots[render_pool.list_index[slot]] = -1;
+    list->holes++;
+
+    if (list->grid)
+        grid_remove(list->grid, slot);
+    render_pool.owner[slot] = NULL;
+    return self;
+}
+
+static VALUE draw_list_set_y_sort(VALUE self, VALUE enabled)
+{
+    RBDrawList *list;
+    TypedData_Get_Struct(self, RBDrawList, &draw_list_type, list);
+    list->y_sort = RTEST(enabled);
+    list->unsorted++;
+    return enabled;
 }
 
-static VALUE assets_load_music(VALUE self, VALUE filename)
+// every sprite on these layers is baked whether or not it's marked static itself
+static VALUE draw_list_set_static_layers(VALUE self, VALUE layers)
 {
-    Check_Type(filename, T_STRING);
+    RBDrawList *list;
+    TypedData_Get_Struct(self, RBDrawList, &draw_list_type, list);
+    Check_Type(layers, T_ARRAY);
 
-    VALUE cache_val = rb_iv_get(self, "@music");
-    Check_Type(cache_val, T_HASH);
+    int count = RARRAY_LEN(layers);
+    int *values = ALLOC_N(int, count ? count : 1);
+    for (int i = 0; i < count; i++)
+    {
+        VALUE layer = RARRAY_AREF(layers, i);
+        if (!RB_INTEGER_TYPE_P(layer))
+        {
+            xfree(values);
+            rb_raise(rb_eTypeError, "layer is not an Integer");
+        }
+        values[i] = NUM2INT(layer);
+    }
 
-    VALUE music_val = rb_hash_lookup(cache_val, filename);
-    assert(rb_obj_is_kind_of(music_val, music_class));
+    // both the old and new static layers need baking again
+    for (int i = 0; i < list->static_layer_count; i++)
+        static_cache_for(list, list->static_layers[i])->dirty = true;
+    xfree(list->static_layers);
+    list->static_layers = values;
+    list->static_layer_count = count;
+    for (int i = 0; i < count; i++)
+        static_cache_for(list, values[i])->dirty = true;
+    return layers;
+}
 
-    if (music_val == Qnil)
+// sprites of equal z on these layers are ordered by texture instead of when they were added
+static VALUE draw_list_set_batch_layers(VALUE self, VALUE layers)
+{
+    RBDrawList *list;
+    TypedData_Get_Struct(self, RBDrawList, &draw_list_type, list);
+    Check_Type(layers, T_ARRAY);
+
+    int count = RARRAY_LEN(layers);
+    int *values = ALLOC_N(int, count ? count : 1);
+    for (int i = 0; i < count; i++)
     {
-        // cache doesn't have an entry at this key, make a new one
-        RBMusic *music;
-        music_val = TypedData_Make_Struct(music_class, RBMusic, &music_type, music);
-        music->music = LoadMusicStream(StringValueCStr(filename));
-        // TODO: should raise error if music loading failed
-        rb_hash_aset(cache_val, filename, music_val);
+        VALUE layer = RARRAY_AREF(layers, i);
+        if (!RB_INTEGER_TYPE_P(layer))
+        {
+            xfree(values);
+            rb_raise(rb_eTypeError, "layer is not an Integer");
+        }
+        values[i] = NUM2INT(layer);
     }
 
-    // if cache already has this entry, just return it
-    return music_val;
+    xfree(list->batch_layers);
+    list->batch_layers = values;
+    list->batch_layer_count = count;
+    list->unsorted++;
+    return layers;
 }
 
-static VALUE texture_width(VALUE self)
+static VALUE draw_list_size(VALUE self)
 {
-    RBTexture *tex;
-    TypedData_Get_Struct(self, RBTexture, &texture_type, tex);
-    return DBL2NUM(tex->texture.width);
+    RBDrawList *list;
+    TypedData_Get_Struct(self, RBDrawList, &draw_list_type, list);
+    return INT2NUM(list->count - list->holes);
 }
 
-static VALUE texture_height(VALUE self)
+static VALUE collision_world_alloc(VALUE self)
 {
-    RBTexture *tex;
-    TypedData_Get_Struct(self, RBTexture, &texture_type, tex);
-    return DBL2NUM(tex->texture.height);
+    RBCollisionWorld *world;
+    return TypedData_Make_Struct(self, RBCollisionWorld, &collision_world_type, world);
 }
 
-static VALUE music_play(VALUE self)
+static void collision_world_order_push(RBCollisionWorld *world, int body)
 {
-    RBMusic *music;
-    TypedData_Get_Struct(self, RBMusic, &music_type, music);
-    PlayMusicStream(music->music);
-    current_music = music;
-    return Qnil;
+    if (world->order_count == world->order_capacity)
+    {
+        world->order_capacity = world->order_capacity ? world->order_capacity * 2 : 64;
+        REALLOC_N(world->order, int, world->order_capacity);
+    }
+    world->order_pos[body] = world->order_count;
+    world->order[world->order_count++] = body;
 }
 
-static VALUE music_stop(VALUE self)
+// registers a game object's hitbox, or replaces it if the object already has one
+// the hitbox is relative to the top left corner of the object's sprite
+// drops the slot's body from the world it belongs to
+static void collision_world_detach(RBCollisionWorld *world, int slot)
 {
-    if (current_music)
+    // leave a hole in the sort order, it gets compacted on the next step
+    int body = render_pool.body[slot];
+    world->order[world->order_pos[body]] = -1;
+    render_pool.body[slot] = -1;
+    render_pool.body_world[slot] = NULL;
+
+    // swap the last body into the removed one's place
+    int last = --world->count;
+    if (body != last)
     {
-        StopMusicStream(current_music->music);
-        current_music = NULL;
+        world->objects[body] = world->objects[last];
+        world->slots[body] = world->slots[last];
+        world->hitboxes[body] = world->hitboxes[last];
+        world->callbacks[body] = world->callbacks[last];
+        world->order_pos[body] = world->order_pos[last];
+        world->order[world->order_pos[body]] = body;
+        render_pool.body[world->slots[body]] = body;
     }
-    return Qnil;
 }
 
-static VALUE sound_play(VALUE self)
+static VALUE collision_world_add(VALUE self, VALUE obj, VALUE hitbox)
 {
-    RBSound *sound;
-    TypedData_Get_Struct(self, RBSound, &sound_type, sound);
-    PlaySound(sound->sound);
-    return Qnil;
+    if (!rb_obj_is_kind_of(hitbox, rect_class))
+        rb_raise(rb_eTypeError, "hitbox is not a Rect");
+
+    int slot = game_object_render_slot(obj);
+    if (slot < 0)
+        rb_raise(rb_eArgError, "Only game objects with a texture can have a hitbox");
+
+    RBCollisionWorld *world;
+    TypedData_Get_Struct(self, RBCollisionWorld, &collision_world_type, world);
+
+    Rectangle *rect;
+    TypedData_Get_Struct(hitbox, Rectangle, &rect_type, rect);
+
+    if (render_pool.body_world[slot] == world)
+    {
+        world->hitboxes[render_pool.body[slot]] = *rect;
+        return self;
+    }
+    // a slot has one body, moving to another scene's world takes it out of the old one
+    if (render_pool.body_world[slot])
+        collision_world_detach(render_pool.body_world[slot], slot);
+
+    if (world->count == world->capacity)
+    {
+        world->capacity = world->capacity ? world->capacity * 2 : 64;
+        REALLOC_N(world->objects, VALUE, world->capacity);
+        REALLOC_N(world->slots, int, world->capacity);
+        REALLOC_N(world->hitboxes, Rectangle, world->capacity);
+        REALLOC_N(world->aabbs, Rectangle, world->capacity);
+        REALLOC_N(world->callbacks, bool, world->capacity);
+        REALLOC_N(world->order_pos, int, world->capacity);
+    }
+
+    int body = world->count++;
+    world->objects[body] = obj;
+    world->slots[body] = slot;
+    world->hitboxes[body] = *rect;
+    world->callbacks[body] = rb_respond_to(obj, rb_intern("on_collide"));
+    render_pool.body[slot] = body;
+    render_pool.body_world[slot] = world;
+    collision_world_order_push(world, body);
+
+    return self;
 }
 
-// creates default render props with internally on game object, called on init
-// width and height defaults to the passed texture's width and height, everything else is zero
-static VALUE game_object_make_render_props(VALUE self, VALUE texture)
+static VALUE collision_world_remove(VALUE self, VALUE obj)
 {
-    assert(rb_obj_is_kind_of(texture, texture_class));
+    int slot = game_object_render_slot(obj);
+    if (slot < 0)
+        return self;
 
-    RBRenderProps *robj;
-    VALUE robj_val = TypedData_Make_Struct(render_props_class, RBRenderProps, &render_props_type, robj);
+    RBCollisionWorld *world;
+    TypedData_Get_Struct(self, RBCollisionWorld, &collision_world_type, world);
 
-    RBTexture *tex;
-    TypedData_Get_Struct(texture, RBTexture, &texture_type, tex);
+    if (render_pool.body_world[slot] == world)
+        collision_world_detach(world, slot);
+    return self;
+}
 
-    robj->x = 0;
-    robj->y = 0;
-    robj->width = tex->texture.width;
-    robj->height = tex->texture.height;
-    robj->angle = 0;
-    robj->frame = (Rectangle){
-        .x = 0,
-        .y = 0,
-        .width = tex->texture.width,
-        .height = tex->texture.height,
-    };
-    robj->origin_x = 0;
-    robj->origin_y = 0;
+// all pairs from the last step where one side is a type_a and the other a type_b, ordered [type_a, type_b]
+static VALUE collision_world_pairs(VALUE self, VALUE type_a, VALUE type_b)
+{
+    RBCollisionWorld *world;
+    TypedData_Get_Struct(self, RBCollisionWorld, &collision_world_type, world);
 
-    return robj_val;
+    VALUE result = rb_ary_new();
+    for (int i = 0; i < world->pair_count; i++)
+    {
+        RBCollisionPair pair = world->pairs[i];
+
+        // skip objects destroyed since the step, usually by an on_collide callback
+        if (!collision_world_contains(world, pair.a, pair.slot_a) || !collision_world_contains(world, pair.b, pair.slot_b))
+            continue;
+
+        if (rb_obj_is_kind_of(pair.a, type_a) && rb_obj_is_kind_of(pair.b, type_b))
+            rb_ary_push(result, rb_assoc_new(pair.a, pair.b));
+        else if (rb_obj_is_kind_of(pair.b, type_a) && rb_obj_is_kind_of(pair.a, type_b))
+            rb_ary_push(result, rb_assoc_new(pair.b, pair.a));
+    }
+    return result;
 }
 
-static VALUE render_props_x_getter(VALUE self)
+// world space hitbox of a registered object, nil if it has none
+static VALUE collision_world_hitbox(VALUE self, VALUE obj)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return DBL2NUM(props->x);
+    int slot = game_object_render_slot(obj);
+    if (slot < 0)
+        return Qnil;
+
+    RBCollisionWorld *world;
+    TypedData_Get_Struct(self, RBCollisionWorld, &collision_world_type, world);
+
+    if (!collision_world_contains(world, obj, slot))
+        return Qnil;
+
+    Rectangle hitbox = world->hitboxes[render_pool.body[slot]];
+    Rectangle *rect;
+    VALUE rect_val = TypedData_Make_Struct(rect_class, Rectangle, &rect_type, rect);
+    *rect = (Rectangle){
+        .x = render_pool.x[slot] - render_pool.origin_x[slot] + hitbox.x,
+        .y = render_pool.y[slot] - render_pool.origin_y[slot] + hitbox.y,
+        .width = hitbox.width,
+        .height = hitbox.height};
+    return rect_val;
 }
 
-static VALUE render_props_y_getter(VALUE self)
+static VALUE collision_world_size(VALUE self)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return DBL2NUM(props->y);
+    RBCollisionWorld *world;
+    TypedData_Get_Struct(self, RBCollisionWorld, &collision_world_type, world);
+    return INT2NUM(world->count);
 }
 
-static VALUE render_props_width_getter(VALUE self)
+static VALUE ticker_manager_alloc(VALUE self)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return DBL2NUM(props->width);
+    RBTickerManager *manager;
+    VALUE manager_val = TypedData_Make_Struct(self, RBTickerManager, &ticker_manager_type, manager);
+    manager->slots = st_init_numtable();
+    return manager_val;
 }
 
-static VALUE render_props_height_getter(VALUE self)
+static RBTicker *ticker_manager_find(VALUE self, ID name_id)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return DBL2NUM(props->height);
+    RBTickerManager *manager;
+    TypedData_Get_Struct(self, RBTickerManager, &ticker_manager_type, manager);
+
+    st_data_t slot;
+    if (!st_lookup(manager->slots, (st_data_t)name_id, &slot))
+        rb_raise(rb_eArgError, "Unknown ticker: %s", rb_id2name(name_id));
+    return &ticker_pool[slot];
 }
 
-static VALUE render_props_angle_getter(VALUE self)
+// body of the reader method defined per ticker, eg. ticker.walk, which it finds by the name it was called as
+static VALUE ticker_manager_read(VALUE self)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return DBL2NUM(props->angle);
+    return INT2NUM(ticker_manager_find(self, rb_frame_callee())->value);
 }
 
-static VALUE render_props_frame_getter(VALUE self)
+static VALUE ticker_manager_value(VALUE self, VALUE name)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-
-    Rectangle *rect;
-    VALUE rect_val = TypedData_Make_Struct(rect_class, Rectangle, &rect_type, rect);
-    *rect = props->frame;
-    return rect_val;
+    return INT2NUM(ticker_manager_find(self, rb_to_id(name))->value);
 }
 
-static VALUE render_props_hflip_getter(VALUE self)
+static VALUE ticker_manager_add(VALUE self, VALUE name, VALUE rate, VALUE limit, VALUE on_complete)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return props->hflip ? Qtrue : Qfalse;
+    if (!NIL_P(on_complete) && !rb_obj_is_proc(on_complete))
+        rb_raise(rb_eTypeError, "Ticker callback must be a Proc");
+
+    RBTickerManager *manager;
+    TypedData_Get_Struct(self, RBTickerManager, &ticker_manager_type, manager);
+
+    ID name_id = rb_to_id(name);
+    int rate_val = NUM2INT(rate);
+    int limit_val = NUM2INT(limit);
+
+    // redefining a ticker starts it over
+    st_data_t slot;
+    if (!st_lookup(manager->slots, (st_data_t)name_id, &slot))
+    {
+        slot = ticker_pool_alloc();
+        st_insert(manager->slots, (st_data_t)name_id, slot);
+        rb_define_singleton_method(self, rb_id2name(name_id), ticker_manager_read, 0);
+    }
+
+    RBTicker *t = &ticker_pool[slot];
+    *t = (RBTicker){
+        .next_free = -1, .rate = rate_val, .limit = limit_val, .generation = t->generation + 1, .on_complete = on_complete};
+    return Qnil;
 }
 
-static VALUE render_props_vflip_getter(VALUE self)
+static VALUE ticker_manager_remove(VALUE self, VALUE name)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return props->vflip ? Qtrue : Qfalse;
+    RBTickerManager *manager;
+    TypedData_Get_Struct(self, RBTickerManager, &ticker_manager_type, manager);
+
+    st_data_t key = (st_data_t)rb_to_id(name);
+    st_data_t slot;
+    if (!st_delete(manager->slots, &key, &slot))
+        rb_raise(rb_eArgError, "Unknown ticker: %s", rb_id2name((ID)key));
+
+    ticker_pool_release((int)slot);
+    rb_undef_method(rb_singleton_class(self), rb_id2name((ID)key));
+    return Qnil;
 }
 
-static VALUE render_props_origin_x_getter(VALUE self)
+static int ticker_manager_clear_slot(st_data_t key, st_data_t slot, st_data_t arg)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return DBL2NUM(props->origin_x);
+    ticker_pool_release((int)slot);
+    rb_undef_method(rb_singleton_class((VALUE)arg), rb_id2name((ID)key));
+    return ST_DELETE;
 }
 
-static VALUE render_props_origin_y_getter(VALUE self)
+// removes every ticker, for objects leaving their scene, see Scene#remove_object and GameObject#recycle
+static VALUE ticker_manager_clear(VALUE self)
 {
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    return DBL2NUM(props->origin_y);
+    RBTickerManager *manager;
+    TypedData_Get_Struct(self, RBTickerManager, &ticker_manager_type, manager);
+    st_foreach(manager->slots, ticker_manager_clear_slot, (st_data_t)self);
+    return Qnil;
 }
 
-static VALUE render_props_x_setter(VALUE self, VALUE val)
+static VALUE ticker_manager_start(VALUE self, VALUE name)
 {
-    if (!rb_obj_is_kind_of(val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "x is not a Numeric");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->x = NUM2DBL(val);
-    return self;
+    ticker_manager_find(self, rb_to_id(name))->running = true;
+    return Qnil;
 }
 
-static VALUE render_props_y_setter(VALUE self, VALUE val)
+static VALUE ticker_manager_halt(VALUE self, VALUE name, VALUE reset)
 {
-    if (!rb_obj_is_kind_of(val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "y is not a Numeric");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->y = NUM2DBL(val);
-    return self;
+    RBTicker *t = ticker_manager_find(self, rb_to_id(name));
+    t->running = false;
+    if (RTEST(reset))
+    {
+        t->counter = 0;
+        t->value = 0;
+    }
+    return Qnil;
 }
 
-static VALUE render_props_width_setter(VALUE self, VALUE val)
+static VALUE ticker_manager_running(VALUE self, VALUE name)
 {
-    if (!rb_obj_is_kind_of(val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "width is not a Numeric");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->width = NUM2DBL(val);
-    return self;
+    return ticker_manager_find(self, rb_to_id(name))->running ? Qtrue : Qfalse;
 }
 
-static VALUE render_props_height_setter(VALUE self, VALUE val)
+static VALUE debug_draw_stats(VALUE self)
 {
-    if (!rb_obj_is_kind_of(val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "height is not a Numeric");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->height = NUM2DBL(val);
-    return self;
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("drawn")), INT2NUM(draw_stats_drawn));
+    rb_hash_aset(stats, ID2SYM(rb_intern("culled")), INT2NUM(draw_stats_culled));
+    rb_hash_aset(stats, ID2SYM(rb_intern("particles")), INT2NUM(draw_stats_particles));
+    rb_hash_aset(stats, ID2SYM(rb_intern("chunks")), INT2NUM(draw_stats_chunks));
+    rb_hash_aset(stats, ID2SYM(rb_intern("chunk_renders")), INT2NUM(draw_stats_chunk_renders));
+    rb_hash_aset(stats, ID2SYM(rb_intern("texture_switches")), INT2NUM(draw_stats_texture_switches));
+    rb_hash_aset(stats, ID2SYM(rb_intern("static")), INT2NUM(draw_stats_static));
+    rb_hash_aset(stats, ID2SYM(rb_intern("static_bakes")), INT2NUM(draw_stats_static_bakes));
+    rb_hash_aset(stats, ID2SYM(rb_intern("draw_calls")), INT2NUM(frame_draw_calls));
+    return stats;
 }
 
-static VALUE render_props_angle_setter(VALUE self, VALUE val)
+static VALUE debug_audio_stats(VALUE self)
 {
-    if (!rb_obj_is_kind_of(val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "angle is not a Numeric");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->angle = NUM2DBL(val);
-    return self;
+    audio_reap(NULL);
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("active")), INT2NUM(active_voice_count));
+    rb_hash_aset(stats, ID2SYM(rb_intern("max")), INT2NUM(max_active_voices));
+    rb_hash_aset(stats, ID2SYM(rb_intern("played")), LONG2NUM(audio_stats_played));
+    rb_hash_aset(stats, ID2SYM(rb_intern("stolen")), LONG2NUM(audio_stats_stolen));
+    rb_hash_aset(stats, ID2SYM(rb_intern("dropped")), LONG2NUM(audio_stats_dropped));
+    rb_hash_aset(stats, ID2SYM(rb_intern("music_refills")), LONG2NUM(atomic_load(&music_stats_refills)));
+    rb_hash_aset(stats, ID2SYM(rb_intern("music_underruns")), LONG2NUM(atomic_load(&music_stats_underruns)));
+    rb_hash_aset(stats, ID2SYM(rb_intern("music_commands")), LONG2NUM(atomic_load(&music_stats_commands)));
+    rb_hash_aset(stats, ID2SYM(rb_intern("music_fades")), LONG2NUM(atomic_load(&music_stats_fades)));
+    rb_hash_aset(stats, ID2SYM(rb_intern("music_stops")), LONG2NUM(atomic_load(&music_stats_stops)));
+    return stats;
 }
 
-static VALUE render_props_frame_setter(VALUE self, VALUE val)
+static VALUE debug_gc_stats(VALUE self)
 {
-    if (!rb_obj_is_kind_of(val, rect_class))
-        rb_raise(rb_eTypeError, "frame is not a Rect");
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("mode")), ID2SYM(rb_intern(gc_stats.mode == GC_MODE_FRAME ? "frame" : "ruby")));
+    rb_hash_aset(stats, ID2SYM(rb_intern("frames")), LONG2NUM(gc_stats.frames));
+    rb_hash_aset(stats, ID2SYM(rb_intern("time_ms")), DBL2NUM(gc_stats.time_ms));
+    rb_hash_aset(stats, ID2SYM(rb_intern("max_frame_ms")), DBL2NUM(gc_stats.max_frame_ms));
+    rb_hash_aset(stats, ID2SYM(rb_intern("last_frame_ms")), DBL2NUM(gc_stats.last_frame_ms));
+    rb_hash_aset(stats, ID2SYM(rb_intern("allocated")), LONG2NUM(gc_stats.allocated));
+    rb_hash_aset(stats, ID2SYM(rb_intern("max_frame_allocated")), LONG2NUM(gc_stats.max_frame_allocated));
+    rb_hash_aset(stats, ID2SYM(rb_intern("last_frame_allocated")), LONG2NUM(gc_stats.last_frame_allocated));
+    rb_hash_aset(stats, ID2SYM(rb_intern("minor")), LONG2NUM(gc_stats.minor));
+    rb_hash_aset(stats, ID2SYM(rb_intern("major")), LONG2NUM(gc_stats.major));
+    rb_hash_aset(stats, ID2SYM(rb_intern("scheduled_minor")), LONG2NUM(gc_stats.scheduled_minor));
+    rb_hash_aset(stats, ID2SYM(rb_intern("scheduled_major")), LONG2NUM(gc_stats.scheduled_major));
+    rb_hash_aset(stats, ID2SYM(rb_intern("forced")), LONG2NUM(gc_stats.forced));
+    rb_hash_aset(stats, ID2SYM(rb_intern("scene_switches")), LONG2NUM(gc_stats.scene_switches));
+    return stats;
+}
 
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
+static VALUE debug_set_profile(VALUE self, VALUE enabled)
+{
+    if (RTEST(enabled) && !profile_enabled)
+        profile_reset();
+    profile_enabled = RTEST(enabled);
+    profile_current = NULL;
+    return enabled;
+}
 
-    Rectangle *rect;
-    TypedData_Get_Struct(val, Rectangle, &rect_type, rect);
+static VALUE debug_profile_p(VALUE self)
+{
+    return profile_enabled ? Qtrue : Qfalse;
+}
 
-    props->frame = *rect;
-    return self;
+static VALUE debug_set_profile_classes(VALUE self, VALUE enabled)
+{
+    profile_classes_enabled = RTEST(enabled);
+    return enabled;
 }
 
-static VALUE render_props_hflip_setter(VALUE self, VALUE val)
+static VALUE debug_set_profile_overlay(VALUE self, VALUE enabled)
 {
-    if (val != Qtrue && val != Qfalse)
-        rb_raise(rb_eTypeError, "hflip is not a Boolean");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->hflip = val == Qtrue;
-    return self;
+    profile_overlay = RTEST(enabled);
+    return enabled;
 }
 
-static VALUE render_props_vflip_setter(VALUE self, VALUE val)
+// resizing the ring buffer drops the frames recorded so far
+static VALUE debug_set_profile_frames(VALUE self, VALUE frames)
 {
-    if (val != Qtrue && val != Qfalse)
-        rb_raise(rb_eTypeError, "vflip is not a Boolean");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->vflip = val == Qtrue;
-    return self;
+    int capacity = NUM2INT(frames);
+    if (capacity < 1)
+        rb_raise(rb_eArgError, "Profiler needs room for at least one frame, got %d", capacity);
+
+    profile_capacity = capacity;
+    profile_reset();
+    return frames;
 }
 
-static VALUE render_props_origin_x_setter(VALUE self, VALUE val)
+// recorded frames from oldest to newest, times are in milliseconds
+static VALUE debug_frame_stats(VALUE self)
 {
-    if (!rb_obj_is_kind_of(val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "x origin is not a Numeric");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->origin_x = NUM2DBL(val);
-    return self;
+    VALUE frames = rb_ary_new_capa(profile_count);
+    for (int i = 0; i < profile_count; i++)
+    {
+        RBProfileFrame *frame = &profile_frames[(profile_head - profile_count + i + profile_capacity) % profile_capacity];
+
+        VALUE phases = rb_hash_new();
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++)
+            rb_hash_aset(phases, ID2SYM(rb_intern(profile_phase_names[phase])), DBL2NUM(frame->phases[phase] * 1000.0));
+
+        VALUE stats = rb_hash_new();
+        rb_hash_aset(stats, ID2SYM(rb_intern("frame")), LONG2NUM(frame->frame));
+        rb_hash_aset(stats, ID2SYM(rb_intern("start_ms")), DBL2NUM((frame->start - profile_epoch) * 1000.0));
+        rb_hash_aset(stats, ID2SYM(rb_intern("total_ms")), DBL2NUM(profile_frame_total(frame) * 1000.0));
+        rb_hash_aset(stats, ID2SYM(rb_intern("phases")), phases);
+        rb_hash_aset(stats, ID2SYM(rb_intern("gc_ms")), DBL2NUM(frame->gc_ms));
+        rb_hash_aset(stats, ID2SYM(rb_intern("allocated")), LONG2NUM(frame->allocated));
+        rb_ary_push(frames, stats);
+    }
+    return frames;
 }
 
-static VALUE render_props_origin_y_setter(VALUE self, VALUE val)
+// update cost per GameObject class, for the latest frame and in total since profiling was enabled
+static VALUE debug_class_stats(VALUE self)
 {
-    if (!rb_obj_is_kind_of(val, rb_cNumeric))
-        rb_raise(rb_eTypeError, "y origin is not a Numeric");
-    RBRenderProps *props;
-    TypedData_Get_Struct(self, RBRenderProps, &render_props_type, props);
-    props->origin_y = NUM2DBL(val);
-    return self;
+    VALUE classes = rb_hash_new();
+    for (int i = 0; i < profile_class_count; i++)
+    {
+        RBProfileClass *class_stats = &profile_class_stats[i];
+        if (class_stats->total_calls == 0)
+            continue;
+
+        VALUE stats = rb_hash_new();
+        rb_hash_aset(stats, ID2SYM(rb_intern("ms")), DBL2NUM(class_stats->frame_seconds * 1000.0));
+        rb_hash_aset(stats, ID2SYM(rb_intern("calls")), LONG2NUM(class_stats->frame_calls));
+        rb_hash_aset(stats, ID2SYM(rb_intern("total_ms")), DBL2NUM(class_stats->total_seconds * 1000.0));
+        rb_hash_aset(stats, ID2SYM(rb_intern("total_calls")), LONG2NUM(class_stats->total_calls));
+        rb_hash_aset(classes, class_stats->klass, stats);
+    }
+    return classes;
 }
 
 static VALUE rect_alloc(VALUE self)
@@ -806,6 +6896,141 @@ static VALUE rect_h_setter(VALUE self, VALUE val)
     return Qnil;
 }
 
+static VALUE rect_initialize_copy(VALUE self, VALUE other)
+{
+    *get_rect(self) = *get_rect(other);
+    return self;
+}
+
+// edges
+
+static VALUE rect_bottom_getter(VALUE self)
+{
+    Rectangle *rect = get_rect(self);
+    return DBL2NUM(rect->y + rect->height);
+}
+
+static VALUE rect_bottom_setter(VALUE self, VALUE val)
+{
+    Rectangle *rect = get_rect(self);
+    rect->y = NUM2DBL(val) - rect->height;
+    return val;
+}
+
+static VALUE rect_right_getter(VALUE self)
+{
+    Rectangle *rect = get_rect(self);
+    return DBL2NUM(rect->x + rect->width);
+}
+
+static VALUE rect_right_setter(VALUE self, VALUE val)
+{
+    Rectangle *rect = get_rect(self);
+    rect->x = NUM2DBL(val) - rect->width;
+    return val;
+}
+
+static VALUE rect_centerx_getter(VALUE self)
+{
+    Rectangle *rect = get_rect(self);
+    return DBL2NUM(rect->x + rect->width / 2.0f);
+}
+
+static VALUE rect_centerx_setter(VALUE self, VALUE val)
+{
+    Rectangle *rect = get_rect(self);
+    rect->x = NUM2DBL(val) - rect->width / 2.0f;
+    return val;
+}
+
+static VALUE rect_centery_getter(VALUE self)
+{
+    Rectangle *rect = get_rect(self);
+    return DBL2NUM(rect->y + rect->height / 2.0f);
+}
+
+static VALUE rect_centery_setter(VALUE self, VALUE val)
+{
+    Rectangle *rect = get_rect(self);
+    rect->y = NUM2DBL(val) - rect->height / 2.0f;
+    return val;
+}
+
+// corners, midpoints and center are points at a fraction of the rect's size
+// getters take an optional Vector2 to write into, setters move the rect so that point lands on the value
+
+static VALUE rect_anchor_get(int argc, VALUE *argv, VALUE self, float fx, float fy)
+{
+    Rectangle *rect = get_rect(self);
+    return vector2_out(argc, argv, (Vector2){rect->x + rect->width * fx, rect->y + rect->height * fy});
+}
+
+static VALUE rect_anchor_set(VALUE self, VALUE val, float fx, float fy)
+{
+    Rectangle *rect = get_rect(self);
+    Vector2 point = vector2_value(val);
+    rect->x = point.x - rect->width * fx;
+    rect->y = point.y - rect->height * fy;
+    return val;
+}
+
+#define RECT_ANCHOR(name, fx, fy)                                               \
+    static VALUE rect_##name##_getter(int argc, VALUE *argv, VALUE self)        \
+    {                                                                           \
+        return rect_anchor_get(argc, argv, self, fx, fy);                       \
+    }                                                                           \
+    static VALUE rect_##name##_setter(VALUE self, VALUE val)                    \
+    {                                                                           \
+        return rect_anchor_set(self, val, fx, fy);                              \
+    }
+
+RECT_ANCHOR(topleft, 0.0f, 0.0f)
+RECT_ANCHOR(topright, 1.0f, 0.0f)
+RECT_ANCHOR(bottomleft, 0.0f, 1.0f)
+RECT_ANCHOR(bottomright, 1.0f, 1.0f)
+RECT_ANCHOR(midtop, 0.5f, 0.0f)
+RECT_ANCHOR(midbottom, 0.5f, 1.0f)
+RECT_ANCHOR(midleft, 0.0f, 0.5f)
+RECT_ANCHOR(midright, 1.0f, 0.5f)
+RECT_ANCHOR(center, 0.5f, 0.5f)
+
+static VALUE rect_size_getter(int argc, VALUE *argv, VALUE self)
+{
+    Rectangle *rect = get_rect(self);
+    return vector2_out(argc, argv, (Vector2){rect->width, rect->height});
+}
+
+static VALUE rect_size_setter(VALUE self, VALUE val)
+{
+    Rectangle *rect = get_rect(self);
+    Vector2 size = vector2_value(val);
+    rect->width = size.x;
+    rect->height = size.y;
+    return val;
+}
+
+// collision
+
+static VALUE rect_collides(VALUE self, VALUE other)
+{
+    if (NIL_P(other))
+        return Qfalse;
+    if (!rb_obj_is_kind_of(other, rect_class))
+        rb_raise(rb_eTypeError, "Can only check collisions against a Rect");
+
+    return rects_overlap(*get_rect(self), *get_rect(other)) ? Qtrue : Qfalse;
+}
+
+static VALUE rect_set(VALUE self, VALUE x, VALUE y, VALUE width, VALUE height)
+{
+    Rectangle *rect = get_rect(self);
+    rect->x = NUM2DBL(x);
+    rect->y = NUM2DBL(y);
+    rect->width = NUM2DBL(width);
+    rect->height = NUM2DBL(height);
+    return self;
+}
+
 static VALUE camera_alloc(VALUE self)
 {
     Camera2D *camera;
@@ -887,22 +7112,63 @@ void Init_rbscene(void)
     rb_define_singleton_method(engine_class, "init", engine_init, 0);
     rb_define_singleton_method(engine_class, "run", engine_run, 0);
     rb_define_singleton_method(engine_class, "update", engine_update, 0);
-
-    VALUE assets_class = rb_define_class_under(rbscene_module, "Assets", rb_cObject);
+    rb_define_singleton_method(engine_class, "stop", engine_stop, 0);
+    rb_define_singleton_method(engine_class, "frame_count", engine_frame_count, 0);
+    rb_define_singleton_method(engine_class, "step_count", engine_step_count, 0);
+    rb_define_singleton_method(engine_class, "stepping?", engine_stepping_p, 0);
+    rb_define_singleton_method(engine_class, "frame_times", engine_frame_times, 0);
+    rb_define_singleton_method(engine_class, "frame_gc_counts", engine_frame_gc_counts, 0);
+
+    assets_class = rb_define_class_under(rbscene_module, "Assets", rb_cObject);
     rb_define_singleton_method(assets_class, "load_texture", assets_load_texture, 1);
     rb_define_singleton_method(assets_class, "load_sound", assets_load_sound, 1);
     rb_define_singleton_method(assets_class, "load_music", assets_load_music, 1);
+    rb_define_singleton_method(assets_class, "load_texture_async", assets_load_texture_async, 1);
+    rb_define_singleton_method(assets_class, "load_sound_async", assets_load_sound_async, 1);
+    rb_define_singleton_method(assets_class, "progress", assets_progress, 0);
+    rb_define_singleton_method(assets_class, "loading?", assets_is_loading, 0);
+    rb_define_singleton_method(assets_class, "wait", assets_wait, 0);
+    rb_define_singleton_method(assets_class, "pack_atlas", assets_pack_atlas, 3);
+    rb_define_singleton_method(assets_class, "atlas_stats", assets_atlas_stats, 0);
+    rb_define_singleton_method(assets_class, "write_pack", assets_write_pack, 4);
+    rb_define_singleton_method(assets_class, "mount", assets_mount, 1);
+    rb_define_singleton_method(assets_class, "load_stats", assets_load_stats, 0);
+    rb_define_singleton_method(assets_class, "cache_stats", assets_cache_stats, 0);
+    rb_define_singleton_method(assets_class, "release_scope", assets_release_scope, 1);
+    rb_define_private_method(rb_singleton_class(assets_class), "cached_assets", assets_cached_assets, 0);
+    rb_funcall(assets_class, rb_intern("private_class_method"), 1, ID2SYM(rb_intern("pack_atlas")));
+
+    // CPU side of atlas packing, usable without a window
+    atlas_packer_class = rb_define_class_under(rbscene_module, "AtlasPacker", rb_cObject);
+    rb_define_alloc_func(atlas_packer_class, atlas_packer_alloc);
+    rb_define_method(atlas_packer_class, "initialize", atlas_packer_initialize, 2);
+    rb_define_method(atlas_packer_class, "insert", atlas_packer_insert_method, 2);
+    rb_define_method(atlas_packer_class, "stats", atlas_packer_stats_method, 0);
 
     texture_class = rb_define_class_under(rbscene_module, "Texture", rb_cObject);
     rb_define_method(texture_class, "width", texture_width, 0);
     rb_define_method(texture_class, "height", texture_height, 0);
+    rb_define_method(texture_class, "atlas?", texture_is_atlas_region, 0);
+    rb_define_method(texture_class, "loaded?", texture_is_loaded, 0);
 
     music_class = rb_define_class_under(rbscene_module, "Music", rb_cObject);
-    rb_define_singleton_method(music_class, "stop", music_stop, 0);
-    rb_define_method(music_class, "play", music_play, 0);
+    rb_global_variable(&music_playing);
+    rb_global_variable(&music_fading);
+    rb_define_singleton_method(music_class, "volume=", music_set_volume, 1);
+    rb_define_private_method(rb_singleton_class(music_class), "fade_out", music_fade_out, 1);
+    rb_define_private_method(music_class, "start", music_start, 2);
 
     sound_class = rb_define_class_under(rbscene_module, "Sound", rb_cObject);
-    rb_define_method(sound_class, "play", sound_play, 0);
+    rb_define_singleton_method(sound_class, "max_voices", sound_s_max_voices, 0);
+    rb_define_singleton_method(sound_class, "max_voices=", sound_s_set_max_voices, 1);
+    rb_define_method(sound_class, "play", sound_play, -1);
+    rb_define_method(sound_class, "stop", sound_stop, 0);
+    rb_define_method(sound_class, "voices", sound_voices, 0);
+    rb_define_method(sound_class, "loaded?", sound_is_loaded, 0);
+    rb_define_method(sound_class, "max_voices", sound_max_voices, 0);
+    rb_define_method(sound_class, "max_voices=", sound_set_max_voices, 1);
+    rb_define_method(sound_class, "priority", sound_priority, 0);
+    rb_define_method(sound_class, "priority=", sound_set_priority, 1);
 
     render_props_class = rb_define_class_under(rbscene_module, "RenderProps", rb_cObject);
     rb_define_method(render_props_class, "x", render_props_x_getter, 0);
@@ -910,22 +7176,62 @@ void Init_rbscene(void)
     rb_define_method(render_props_class, "width", render_props_width_getter, 0);
     rb_define_method(render_props_class, "height", render_props_height_getter, 0);
     rb_define_method(render_props_class, "angle", render_props_angle_getter, 0);
-    rb_define_method(render_props_class, "frame", render_props_frame_getter, 0);
+    rb_define_method(render_props_class, "frame", render_props_frame_getter, -1);
+    rb_define_method(render_props_class, "position", render_props_position, -1);
+    rb_define_method(render_props_class, "size", render_props_size, -1);
     rb_define_method(render_props_class, "hflip", render_props_hflip_getter, 0);
     rb_define_method(render_props_class, "vflip", render_props_vflip_getter, 0);
     rb_define_method(render_props_class, "origin_x", render_props_origin_x_getter, 0);
     rb_define_method(render_props_class, "origin_y", render_props_origin_y_getter, 0);
+    rb_define_method(render_props_class, "layer", render_props_layer_getter, 0);
+    rb_define_method(render_props_class, "z", render_props_z_getter, 0);
+    rb_define_method(render_props_class, "layer=", render_props_layer_setter, 1);
+    rb_define_method(render_props_class, "z=", render_props_z_setter, 1);
+    rb_define_method(render_props_class, "static?", render_props_static_getter, 0);
+    rb_define_method(render_props_class, "static=", render_props_static_setter, 1);
     rb_define_method(render_props_class, "x=", render_props_x_setter, 1);
     rb_define_method(render_props_class, "y=", render_props_y_setter, 1);
     rb_define_method(render_props_class, "width=", render_props_width_setter, 1);
     rb_define_method(render_props_class, "height=", render_props_height_setter, 1);
     rb_define_method(render_props_class, "angle=", render_props_angle_setter, 1);
     rb_define_method(render_props_class, "frame=", render_props_frame_setter, 1);
+    rb_define_method(render_props_class, "snap", render_props_snap, 0);
     rb_define_method(render_props_class, "hflip=", render_props_hflip_setter, 1);
     rb_define_method(render_props_class, "vflip=", render_props_vflip_setter, 1);
     rb_define_method(render_props_class, "origin_x=", render_props_origin_x_setter, 1);
     rb_define_method(render_props_class, "origin_y=", render_props_origin_y_setter, 1);
 
+    // internal, scenes keep one for world objects and one for UI objects
+    draw_list_class = rb_define_class_under(rbscene_module, "DrawList", rb_cObject);
+    rb_define_alloc_func(draw_list_class, draw_list_alloc);
+    rb_define_method(draw_list_class, "initialize", draw_list_initialize, -1);
+    rb_define_method(draw_list_class, "add", draw_list_add, 1);
+    rb_define_method(draw_list_class, "remove", draw_list_remove, 1);
+    rb_define_method(draw_list_class, "size", draw_list_size, 0);
+    rb_define_method(draw_list_class, "y_sort=", draw_list_set_y_sort, 1);
+    rb_define_method(draw_list_class, "static_layers=", draw_list_set_static_layers, 1);
+    rb_define_method(draw_list_class, "batch_layers=", draw_list_set_batch_layers, 1);
+
+    // every game object owns one, its tickers live in the engine's pool
+    ticker_manager_class = rb_define_class_under(rbscene_module, "TickerManager", rb_cObject);
+    rb_define_alloc_func(ticker_manager_class, ticker_manager_alloc);
+    rb_define_private_method(ticker_manager_class, "add", ticker_manager_add, 4);
+    rb_define_private_method(ticker_manager_class, "remove", ticker_manager_remove, 1);
+    rb_define_private_method(ticker_manager_class, "halt", ticker_manager_halt, 2);
+    rb_define_method(ticker_manager_class, "start", ticker_manager_start, 1);
+    rb_define_method(ticker_manager_class, "running?", ticker_manager_running, 1);
+    rb_define_method(ticker_manager_class, "value", ticker_manager_value, 1);
+    rb_define_method(ticker_manager_class, "clear", ticker_manager_clear, 0);
+
+    // internal, every scene owns one
+    collision_world_class = rb_define_class_under(rbscene_module, "CollisionWorld", rb_cObject);
+    rb_define_alloc_func(collision_world_class, collision_world_alloc);
+    rb_define_method(collision_world_class, "add", collision_world_add, 2);
+    rb_define_method(collision_world_class, "remove", collision_world_remove, 1);
+    rb_define_method(collision_world_class, "pairs", collision_world_pairs, 2);
+    rb_define_method(collision_world_class, "hitbox", collision_world_hitbox, 1);
+    rb_define_method(collision_world_class, "size", collision_world_size, 0);
+
     rect_class = rb_define_class_under(rbscene_module, "Rect", rb_cObject);
     rb_define_alloc_func(rect_class, rect_alloc);
     rb_define_method(rect_class, "initialize", rect_initialize, 4);
@@ -937,6 +7243,113 @@ void Init_rbscene(void)
     rb_define_method(rect_class, "y=", rect_y_setter, 1);
     rb_define_method(rect_class, "w=", rect_w_setter, 1);
     rb_define_method(rect_class, "h=", rect_h_setter, 1);
+    rb_define_method(rect_class, "initialize_copy", rect_initialize_copy, 1);
+    rb_define_method(rect_class, "set", rect_set, 4);
+    rb_define_method(rect_class, "top", rect_y_getter, 0);
+    rb_define_method(rect_class, "top=", rect_y_setter, 1);
+    rb_define_method(rect_class, "left", rect_x_getter, 0);
+    rb_define_method(rect_class, "left=", rect_x_setter, 1);
+    rb_define_method(rect_class, "width", rect_w_getter, 0);
+    rb_define_method(rect_class, "width=", rect_w_setter, 1);
+    rb_define_method(rect_class, "height", rect_h_getter, 0);
+    rb_define_method(rect_class, "height=", rect_h_setter, 1);
+    rb_define_method(rect_class, "bottom", rect_bottom_getter, 0);
+    rb_define_method(rect_class, "bottom=", rect_bottom_setter, 1);
+    rb_define_method(rect_class, "right", rect_right_getter, 0);
+    rb_define_method(rect_class, "right=", rect_right_setter, 1);
+    rb_define_method(rect_class, "centerx", rect_centerx_getter, 0);
+    rb_define_method(rect_class, "centerx=", rect_centerx_setter, 1);
+    rb_define_method(rect_class, "centery", rect_centery_getter, 0);
+    rb_define_method(rect_class, "centery=", rect_centery_setter, 1);
+    rb_define_method(rect_class, "topleft", rect_topleft_getter, -1);
+    rb_define_method(rect_class, "topleft=", rect_topleft_setter, 1);
+    rb_define_method(rect_class, "topright", rect_topright_getter, -1);
+    rb_define_method(rect_class, "topright=", rect_topright_setter, 1);
+    rb_define_method(rect_class, "bottomleft", rect_bottomleft_getter, -1);
+    rb_define_method(rect_class, "bottomleft=", rect_bottomleft_setter, 1);
+    rb_define_method(rect_class, "bottomright", rect_bottomright_getter, -1);
+    rb_define_method(rect_class, "bottomright=", rect_bottomright_setter, 1);
+    rb_define_method(rect_class, "midtop", rect_midtop_getter, -1);
+    rb_define_method(rect_class, "midtop=", rect_midtop_setter, 1);
+    rb_define_method(rect_class, "midbottom", rect_midbottom_getter, -1);
+    rb_define_method(rect_class, "midbottom=", rect_midbottom_setter, 1);
+    rb_define_method(rect_class, "midleft", rect_midleft_getter, -1);
+    rb_define_method(rect_class, "midleft=", rect_midleft_setter, 1);
+    rb_define_method(rect_class, "midright", rect_midright_getter, -1);
+    rb_define_method(rect_class, "midright=", rect_midright_setter, 1);
+    rb_define_method(rect_class, "center", rect_center_getter, -1);
+    rb_define_method(rect_class, "center=", rect_center_setter, 1);
+    rb_define_method(rect_class, "size", rect_size_getter, -1);
+    rb_define_method(rect_class, "size=", rect_size_setter, 1);
+    rb_define_method(rect_class, "collides?", rect_collides, 1);
+
+    vector2_class = rb_define_class_under(rbscene_module, "Vector2", rb_cObject);
+    rb_define_alloc_func(vector2_class, vector2_alloc);
+    rb_define_method(vector2_class, "initialize", vector2_initialize, -1);
+    rb_define_method(vector2_class, "initialize_copy", vector2_initialize_copy, 1);
+    rb_define_method(vector2_class, "x", vector2_x_getter, 0);
+    rb_define_method(vector2_class, "y", vector2_y_getter, 0);
+    rb_define_method(vector2_class, "x=", vector2_x_setter, 1);
+    rb_define_method(vector2_class, "y=", vector2_y_setter, 1);
+    rb_define_method(vector2_class, "set", vector2_set, 2);
+    rb_define_method(vector2_class, "+", vector2_add, 1);
+    rb_define_method(vector2_class, "-", vector2_sub, 1);
+    rb_define_method(vector2_class, "*", vector2_mul, 1);
+    rb_define_method(vector2_class, "/", vector2_div, 1);
+    rb_define_method(vector2_class, "-@", vector2_neg, 0);
+    rb_define_method(vector2_class, "==", vector2_eq, 1);
+    rb_define_method(vector2_class, "add!", vector2_add_bang, 1);
+    rb_define_method(vector2_class, "sub!", vector2_sub_bang, 1);
+    rb_define_method(vector2_class, "scale!", vector2_scale_bang, 1);
+    rb_define_method(vector2_class, "normalize!", vector2_normalize_bang, 0);
+    rb_define_method(vector2_class, "normalize", vector2_normalize, 0);
+    rb_define_method(vector2_class, "lerp!", vector2_lerp_bang, 2);
+    rb_define_method(vector2_class, "lerp", vector2_lerp, 2);
+    rb_define_method(vector2_class, "length", vector2_length, 0);
+    rb_define_method(vector2_class, "dot", vector2_dot, 1);
+    rb_define_method(vector2_class, "distance_to", vector2_distance_to, 1);
+
+    emitter_class = rb_define_class_under(rbscene_module, "Emitter", rb_cObject);
+    rb_define_alloc_func(emitter_class, emitter_alloc);
+    rb_define_method(emitter_class, "x", emitter_x_getter, 0);
+    rb_define_method(emitter_class, "y", emitter_y_getter, 0);
+    rb_define_method(emitter_class, "x=", emitter_x_setter, 1);
+    rb_define_method(emitter_class, "y=", emitter_y_setter, 1);
+    rb_define_method(emitter_class, "move_to", emitter_move_to, 2);
+    rb_define_method(emitter_class, "rate", emitter_rate_getter, 0);
+    rb_define_method(emitter_class, "rate=", emitter_rate_setter, 1);
+    rb_define_method(emitter_class, "gravity", emitter_gravity_getter, 0);
+    rb_define_method(emitter_class, "gravity=", emitter_gravity_setter, 1);
+    rb_define_method(emitter_class, "max_particles", emitter_max_particles, 0);
+    rb_define_method(emitter_class, "max_particles=", emitter_set_max_particles, 1);
+    rb_define_method(emitter_class, "seed=", emitter_set_seed, 1);
+    rb_define_method(emitter_class, "count", emitter_count, 0);
+    rb_define_method(emitter_class, "emitting?", emitter_is_emitting, 0);
+    rb_define_method(emitter_class, "start", emitter_start, 0);
+    rb_define_method(emitter_class, "stop", emitter_stop, 0);
+    rb_define_method(emitter_class, "burst", emitter_burst, 1);
+    rb_define_method(emitter_class, "clear", emitter_clear, 0);
+    rb_define_private_method(emitter_class, "set_range", emitter_set_range, 3);
+    rb_define_private_method(emitter_class, "set_area", emitter_set_area, 2);
+    rb_define_private_method(emitter_class, "set_colors", emitter_set_colors, 2);
+    rb_define_private_method(emitter_class, "set_texture", emitter_set_texture, 2);
+
+    tilemap_class = rb_define_class_under(rbscene_module, "Tilemap", rb_cObject);
+    rb_define_alloc_func(tilemap_class, tilemap_alloc);
+    rb_define_method(tilemap_class, "[]", tilemap_get, 2);
+    rb_define_method(tilemap_class, "[]=", tilemap_set, 3);
+    rb_define_method(tilemap_class, "cols", tilemap_cols, 0);
+    rb_define_method(tilemap_class, "rows", tilemap_rows, 0);
+    rb_define_method(tilemap_class, "tile_width", tilemap_tile_width, 0);
+    rb_define_method(tilemap_class, "tile_height", tilemap_tile_height, 0);
+    rb_define_method(tilemap_class, "x", tilemap_x_getter, 0);
+    rb_define_method(tilemap_class, "y", tilemap_y_getter, 0);
+    rb_define_method(tilemap_class, "move_to", tilemap_move_to, 2);
+    rb_define_method(tilemap_class, "solid_tiles=", tilemap_set_solid_tiles, 1);
+    rb_define_method(tilemap_class, "solid_at?", tilemap_solid_at, 2);
+    rb_define_method(tilemap_class, "solid_in?", tilemap_solid_in, 1);
+    rb_define_private_method(tilemap_class, "setup", tilemap_setup, 5);
+    rb_define_private_method(tilemap_class, "load_tiles", tilemap_load_tiles, 1);
 
     camera_class = rb_define_class_under(rbscene_module, "Camera", rb_cObject);
     rb_define_alloc_func(camera_class, camera_alloc);
@@ -949,10 +7362,27 @@ void Init_rbscene(void)
 
     // reference existing Ruby classes
     game_object_class = rb_const_get(rbscene_module, rb_intern("GameObject"));
+    rb_define_singleton_method(game_object_class, "invalidate_update_cache", game_object_invalidate_update_cache, 0);
+    id_update = rb_intern("update");
+    id_sleeping = rb_intern("@sleeping");
+    update_cache = st_init_numtable();
     rb_define_method(game_object_class, "make_render_props", game_object_make_render_props, 1);
     rb_funcall(game_object_class, rb_intern("private"), 1, ID2SYM(rb_intern("make_render_props"))); // declare make_render_props private
 
     scene_class = rb_const_get(rbscene_module, rb_intern("Scene"));
     input_class = rb_const_get(rbscene_module, rb_intern("Input"));
+    rb_define_private_method(rb_singleton_class(input_class), "bind", input_bind, 2);
+    rb_define_private_method(rb_singleton_class(input_class), "unbind", input_unbind, 1);
+    rb_define_singleton_method(input_class, "axis", input_axis, 1);
     debug_class = rb_const_get(rbscene_module, rb_intern("Debug"));
+    rb_define_singleton_method(debug_class, "draw_stats", debug_draw_stats, 0);
+    rb_define_singleton_method(debug_class, "gc_stats", debug_gc_stats, 0);
+    rb_define_singleton_method(debug_class, "audio_stats", debug_audio_stats, 0);
+    rb_define_singleton_method(debug_class, "profile=", debug_set_profile, 1);
+    rb_define_singleton_method(debug_class, "profile?", debug_profile_p, 0);
+    rb_define_singleton_method(debug_class, "profile_classes=", debug_set_profile_classes, 1);
+    rb_define_singleton_method(debug_class, "profile_overlay=", debug_set_profile_overlay, 1);
+    rb_define_singleton_method(debug_class, "profile_frames=", debug_set_profile_frames, 1);
+    rb_define_singleton_method(debug_class, "frame_stats", debug_frame_stats, 0);
+    rb_define_singleton_method(debug_class, "class_stats", debug_class_stats, 0);
 }
@@ -9,5 +9,89 @@ module RBScene
     def load(path)
       # auto detect file extension and load asset depending on type
     end
+
+    IMAGE_EXTENSIONS = %w[.png .jpg .jpeg .bmp .tga .gif .qoi .hdr].freeze
+    SOUND_EXTENSIONS = %w[.wav .ogg .mp3 .flac .qoa].freeze
+
+    # archive written by `rbscene pack`, boot.rb mounts it when it exists, nil always loads loose files
+    @pack_path = 'assets.rbpack'
+    # assets loaded while a scene is current, released when the next scene takes over, nil loads are pinned
+    @scope = nil
+
+    class << self
+      attr_accessor :pack_path
+
+      # starts loading files in the background, check progress with Assets.progress or each asset's loaded?
+      # images become textures and audio files become sounds, music streams from disk so it isn't preloaded
+      def preload(paths)
+        Array(paths).map do |path|
+          ext = File.extname(path).downcase
+          if IMAGE_EXTENSIONS.include?(ext)
+            load_texture_async(path)
+          elsif SOUND_EXTENSIONS.include?(ext)
+            load_sound_async(path)
+          else
+            raise ArgumentError, "Don't know how to preload #{path}"
+          end
+        end
+      end
+
+      # decodes the images and sounds in paths into one archive at output, see Assets.mount
+      # sounds longer than stream_after seconds stay encoded so they can still be played as music
+      def pack(paths, output = pack_path, stream_after: 10)
+        paths = Dir.glob(paths).sort if paths.is_a?(String)
+        paths = paths.map { |path| path.delete_prefix('./') }.uniq
+        images, sounds = paths.partition { |path| IMAGE_EXTENSIONS.include?(File.extname(path).downcase) }
+        sounds.select! { |path| SOUND_EXTENSIONS.include?(File.extname(path).downcase) }
+        write_pack(output, images, sounds, stream_after)
+      end
+
+      def mount_pack
+        mount(pack_path) if pack_path && File.exist?(pack_path)
+      end
+
+      # loads from here until the next scene takes over belong to the scene the block builds
+      # the previous scene's assets are released after the new one has loaded, so anything they share stays cached
+      # scope can be one made with new_scope that already holds assets preloaded for the scene
+      # a scene that fails to build leaves the previous one's scope current
+      def enter_scene(scope = new_scope, &block)
+        previous = @scope
+        scene = within(scope, &block)
+        @scope = scope
+        release_scope(previous) if previous
+        scene
+      end
+
+      def new_scope
+        {}.compare_by_identity
+      end
+
+      # loads in the block belong to scope instead of the current scene, see Assets.release_scope
+      def within(scope)
+        previous = @scope
+        @scope = scope
+        yield
+      ensure
+        @scope = previous
+      end
+
+      # loads in the block are never evicted, for assets held by classes rather than scenes
+      def pinned(&block)
+        within(nil, &block)
+      end
+
+      # every cached asset with its size and references, largest first, plus cache totals and hit rate
+      def report
+        cache_stats.merge(assets: cached_assets.sort_by { |asset| -asset[:bytes] })
+      end
+
+      # packs images into shared atlas pages so sprites using them can be drawn without texture switches
+      # paths can be an array of files or a glob, returns a hash of path => Texture region
+      # textures loaded before the atlas is built are converted to regions in place
+      def build_atlas(paths, page_size: 2048, padding: 1)
+        paths = Dir.glob(paths).sort if paths.is_a?(String)
+        pack_atlas(paths.uniq, page_size, padding)
+      end
+    end
   end
 end
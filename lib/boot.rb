@@ -2,30 +2,40 @@
 
 # This script is the entry point to your application.
 
+started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
 require 'rbscene'
-
-RBScene::Engine.init
-
-# require gameobjects
-gameobjects = Dir.glob(File.join(Dir.pwd, 'gameobjects', '**', '*.rb')).sort
-if gameobjects.empty?
-  warn 'Warning: No game objects found!'
-else
-  gameobjects.each { |file| require file }
-end
-
-# require scenes
-scenes = Dir.glob(File.join(Dir.pwd, 'scenes', '**', '*.rb')).sort
-if scenes.empty?
-  warn 'Warning: No scenes found!'
-else
-  scenes.each { |file| require file }
+RBScene::Debug.time_startup(:require, started)
+
+RBScene::Debug.time_startup(:init) { RBScene::Engine.init }
+
+# assets in the pack built by `rbscene pack` load from it, everything else loads from disk
+RBScene::Debug.time_startup(:assets) { RBScene::Assets.mount_pack }
+
+# scripts compiled by `rbscene build` load from its cache, classes it found are only loaded once something uses them
+RBScene::Debug.time_startup(:scripts) do
+  # require gameobjects
+  gameobjects = Dir.glob(File.join(Dir.pwd, 'gameobjects', '**', '*.rb')).sort
+  if gameobjects.empty?
+    warn 'Warning: No game objects found!'
+  else
+    RBScene::CodeCache.require_all(gameobjects)
+  end
+
+  # require scenes
+  scenes = Dir.glob(File.join(Dir.pwd, 'scenes', '**', '*.rb')).sort
+  if scenes.empty?
+    warn 'Warning: No scenes found!'
+  else
+    RBScene::CodeCache.require_all(scenes)
+  end
 end
 
 # configure engine
-config = File.expand_path('config.rb', Dir.pwd)
-require config if File.exist?(config)
-RBScene::Engine.update
+RBScene::Debug.time_startup(:config) do
+  config = File.expand_path('config.rb', Dir.pwd)
+  require config if File.exist?(config)
+  RBScene::Engine.update
+end
 
 # default inputs
 RBScene::Input.define('up', [:up])
@@ -34,4 +44,6 @@ RBScene::Input.define('left', [:left])
 RBScene::Input.define('right', [:right])
 RBScene::Input.define('space', [:space])
 
+warn RBScene::Debug.startup_report if RBScene::Debug.report_startup
+
 RBScene::Engine.run
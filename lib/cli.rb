@@ -1,6 +1,8 @@
 # frozen_string_literal: true
 
 require 'fileutils'
+require 'json'
+require 'optparse'
 
 module RBScene
   class CLI
@@ -9,9 +11,15 @@ module RBScene
 
       case command
       when 'dev'
-        run_game
+        dev(argv)
       when 'new'
         new_project
+      when 'bench'
+        bench(argv)
+      when 'pack'
+        pack(argv)
+      when 'build'
+        build
       else
         warn "Unknown command: #{command}"
       end
@@ -23,6 +31,160 @@ module RBScene
       end
     end
 
+    # loose files are loaded in development so edited assets show up without repacking
+    def self.dev(argv)
+      use_pack = false
+      report_startup = false
+      OptionParser.new do |opts|
+        opts.banner = 'Usage: rbscene dev [options]'
+        opts.on('--pack', 'Load assets from the packed archive when there is one') { use_pack = true }
+        opts.on('--startup', 'Print how long each part of startup took') { report_startup = true }
+      end.parse!(argv)
+
+      require 'rbscene'
+      RBScene::Assets.pack_path = nil unless use_pack
+      RBScene::Debug.report_startup = report_startup
+      run_game
+    end
+
+    # decodes every image and sound under the asset directories into one archive that the game maps at startup
+    def self.pack(argv)
+      options = { output: 'assets.rbpack', stream_after: 10 }
+      OptionParser.new do |opts|
+        opts.banner = 'Usage: rbscene pack [options] [directories]'
+        opts.on('-o', '--output PATH', 'Archive to write (default assets.rbpack)') { |path| options[:output] = path }
+        opts.on('--stream-after SECONDS', Float, 'Keep sounds longer than this encoded for streaming (default 10)') do |s|
+          options[:stream_after] = s
+        end
+      end.parse!(argv)
+
+      require 'rbscene'
+      directories = argv.empty? ? ['assets'] : argv
+      paths = directories.flat_map { |dir| Dir.glob(File.join(dir, '**', '*')) }.select { |path| File.file?(path) }.sort
+      abort "Error: No assets found in #{directories.join(', ')}" if paths.empty?
+
+      started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      stats = RBScene::Assets.pack(paths, options[:output], stream_after: options[:stream_after])
+      elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started
+      puts format('Packed %<images>d images, %<sounds>d sounds and %<streamed>d streamed sounds ' \
+                  "into #{options[:output]} (%<mb>.1f MB) in %<s>.2fs",
+                  stats.merge(mb: stats[:bytes] / 1_048_576.0, s: elapsed))
+    end
+
+    # compiles the game's scripts ahead of time, boot loads them from the cache and defers classes until first use
+    def self.build
+      require 'rbscene'
+      scripts = RBScene::CodeCache.scripts
+      abort 'Error: No scripts found in gameobjects or scenes.' if scripts.empty?
+
+      started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      manifest = RBScene::CodeCache.build(scripts)
+      elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started
+      deferred = manifest.values.count { |entry| !entry[:constants].empty? }
+      puts format("Compiled #{manifest.size} scripts into #{RBScene::CodeCache.dir} in %.2fs, " \
+                  "#{deferred} can load on first use", elapsed)
+    end
+
+    # runs the project headless for a fixed number of frames and reports frame times
+    def self.bench(argv)
+      options = { frames: 600, warmup: 60, json: nil, gc: nil, loose: false }
+      OptionParser.new do |opts|
+        opts.banner = 'Usage: rbscene bench [options]'
+        opts.on('--frames N', Integer, 'Frames to measure (default 600)') { |n| options[:frames] = n }
+        opts.on('--warmup N', Integer, 'Frames to run before measuring (default 60)') { |n| options[:warmup] = n }
+        opts.on('--json PATH', 'Also write the results as JSON') { |path| options[:json] = path }
+        opts.on('--gc MODE', %w[ruby frame], 'GC mode to run with, ruby or frame (default from config)') do |mode|
+          options[:gc] = mode.to_sym
+        end
+        opts.on('--loose', 'Load loose asset files even when there is a pack') { options[:loose] = true }
+      end.parse!(argv)
+
+      # config has to be set before boot.rb calls Engine.init
+      require 'rbscene'
+      config = RBScene::Engine.config
+      config.headless = true
+      config.max_frames = options[:warmup] + options[:frames]
+      config.record_frame_times = true
+      config.gc_mode = options[:gc] if options[:gc]
+      RBScene::Assets.pack_path = nil if options[:loose]
+
+      gc_before = GC.count
+      started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      run_game
+      elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started
+
+      results = bench_results(options, elapsed, gc_before)
+      print_bench_results(results)
+      File.write(options[:json], JSON.pretty_generate(results)) if options[:json]
+    end
+
+    def self.bench_results(options, elapsed, gc_before)
+      times = RBScene::Engine.frame_times.drop(options[:warmup])
+      all_gc_counts = RBScene::Engine.frame_gc_counts
+      abort 'Error: No frames were measured.' if times.empty?
+
+      sorted = times.map { |t| t * 1000.0 }.sort
+      percentile = ->(p) { sorted[((sorted.size - 1) * p).round] }
+      gc_start = options[:warmup].positive? ? all_gc_counts[options[:warmup] - 1] : gc_before
+      scene = RBScene::Engine.scene
+
+      {
+        commit: git_commit,
+        frames: times.size,
+        warmup: options[:warmup],
+        elapsed_s: elapsed.round(3),
+        frame_ms: {
+          p50: percentile.call(0.50).round(4),
+          p95: percentile.call(0.95).round(4),
+          p99: percentile.call(0.99).round(4),
+          max: sorted.last.round(4),
+          mean: (sorted.sum / sorted.size).round(4)
+        },
+        gc_runs: all_gc_counts.last - gc_start,
+        gc: GC.stat.slice(:count, :minor_gc_count, :major_gc_count, :total_allocated_objects),
+        gc_schedule: RBScene::Debug.gc_stats,
+        assets: RBScene::Assets.load_stats,
+        asset_cache: RBScene::Assets.cache_stats,
+        audio: RBScene::Debug.audio_stats,
+        startup_ms: RBScene::Debug.startup_times,
+        code_cache: RBScene::CodeCache.stats,
+        ruby_objects: ObjectSpace.count_objects.slice(:TOTAL, :FREE, :T_OBJECT, :T_STRING, :T_ARRAY, :T_HASH),
+        scene: scene.class.name,
+        game_objects: scene.object_count,
+        draw_stats: RBScene::Debug.draw_stats
+      }
+    end
+
+    def self.print_bench_results(results)
+      ms = results[:frame_ms]
+      puts "#{results[:frames]} frames (#{results[:warmup]} warmup) in #{results[:elapsed_s]}s" \
+           "#{" @ #{results[:commit]}" if results[:commit]}"
+      puts format('frame ms  p50 %<p50>.3f  p95 %<p95>.3f  p99 %<p99>.3f  max %<max>.3f  mean %<mean>.3f', ms)
+      puts "gc runs   #{results[:gc_runs]} (minor #{results[:gc][:minor_gc_count]}, " \
+           "major #{results[:gc][:major_gc_count]} total)"
+      schedule = results[:gc_schedule]
+      puts format('gc time   %<time_ms>.1f ms, max %<max_frame_ms>.1f ms in one frame, %<mode>s mode ' \
+                  '(%<scheduled_minor>d minor, %<scheduled_major>d major scheduled, %<forced>d forced)', schedule)
+      puts "startup   #{RBScene::Debug.startup_report.delete_prefix('startup ')}"
+      assets = results[:assets]
+      source = assets[:pack] ? "#{assets[:from_pack]} from #{assets[:pack]}" : 'loose files'
+      puts format('assets    %<loads>d loaded in %<load_ms>.2f ms', assets) + " (#{source})"
+      cache = results[:asset_cache]
+      puts format('cache     %<mb>.1f MB resident, %<rate>.0f%% hits, %<evicted>d evicted',
+                  mb: cache[:resident_bytes] / 1_048_576.0, rate: cache[:hit_rate] * 100, evicted: cache[:evicted])
+      puts format('audio     %<music_refills>d music refills, %<music_underruns>d underruns, ' \
+                  '%<played>d sounds played (%<stolen>d stolen, %<dropped>d dropped)', results[:audio])
+      puts "objects   #{results[:game_objects]} game objects in #{results[:scene]}, " \
+           "#{results[:ruby_objects][:TOTAL] - results[:ruby_objects][:FREE]} live Ruby objects"
+    end
+
+    def self.git_commit
+      commit = `git rev-parse --short HEAD 2>/dev/null`.strip
+      commit.empty? ? nil : commit
+    rescue SystemCallError
+      nil
+    end
+
     def self.new_project
       abort "Error: Directory '#{Dir.pwd}' is not empty." unless Dir.empty?(Dir.pwd)
 
@@ -0,0 +1,144 @@
+# frozen_string_literal: true
+
+require 'digest'
+require 'fileutils'
+
+module RBScene
+  # compiled game scripts written by `rbscene build`, keyed by a hash of each file's contents
+  # require and autoload pick them up through RubyVM::InstructionSequence.load_iseq, a changed file just misses
+  class CodeCache
+    MANIFEST = 'manifest'
+
+    @dir = '.rbscene/cache'
+    @root = nil
+    @manifest = nil
+    @hits = 0
+    @misses = 0
+    @deferred = 0
+
+    class << self
+      attr_accessor :dir
+
+      # everything boot.rb loads from the project
+      def scripts(root = Dir.pwd)
+        scripts = %w[gameobjects scenes].flat_map { |dir| Dir.glob(File.join(root, dir, '**', '*.rb')).sort }
+        config = File.join(root, 'config.rb')
+        File.exist?(config) ? scripts.push(config) : scripts
+      end
+
+      # compiles every script and records which top level classes each one defines so boot can autoload them
+      def build(paths, root = Dir.pwd)
+        FileUtils.mkdir_p(File.join(root, dir))
+        manifest = {}
+        root = File.realpath(root)
+        paths.each do |path|
+          # require hands load_iseq real paths, the key has to be made from the same one
+          path = File.realpath(path, root)
+          source = File.binread(path)
+          digest = key(path, source)
+          File.binwrite(File.join(root, dir, digest), RubyVM::InstructionSequence.compile_file(path).to_binary)
+          manifest[relative(path, root)] = { digest: digest, constants: lazy_constants(source) }
+        end
+        File.binwrite(File.join(root, dir, MANIFEST), Marshal.dump(manifest))
+        manifest
+      end
+
+      # files listed in the manifest that haven't changed since the build, with the constants they can autoload
+      def manifest(root = Dir.pwd)
+        root = File.realpath(root)
+        path = File.join(root, dir, MANIFEST)
+        return {} unless File.exist?(path)
+
+        entries = Marshal.load(File.binread(path)).select do |file, entry|
+          full = File.join(root, file)
+          File.exist?(full) && entry[:digest] == key(full, File.binread(full))
+        end
+
+        # a class reopened in another file has to be loaded from all of them, so those files aren't deferred
+        counts = entries.values.flat_map { |entry| entry[:constants] }.tally
+        entries.transform_values do |entry|
+          entry[:constants].any? { |name| counts[name] > 1 } ? entry.merge(constants: []) : entry
+        end
+      end
+
+      # requires each file, or registers an autoload for the classes the manifest says it defines
+      def require_all(files)
+        enable
+        @manifest ||= @root ? manifest : {}
+        files.each do |file|
+          constants = @manifest.dig(relative(File.realpath(file), File.realpath(Dir.pwd)), :constants)
+          if constants.nil? || constants.empty?
+            require file
+          else
+            constants.each { |name| Object.autoload(name, file) }
+            @deferred += constants.size
+          end
+        end
+      end
+
+      def stats
+        { hits: @hits, misses: @misses, deferred: @deferred }
+      end
+
+      # only files under root go through the cache, gems and the engine compile as usual
+      def enable(root = Dir.pwd)
+        return if @root || !Dir.exist?(File.join(root, dir))
+
+        @root = "#{File.realpath(root)}/"
+        RubyVM::InstructionSequence.singleton_class.prepend(LoadHook)
+      end
+
+      def load(path)
+        return nil unless @root && path.start_with?(@root)
+
+        cached = File.join(@root, dir, key(path, File.binread(path)))
+        unless File.exist?(cached)
+          @misses += 1
+          return nil
+        end
+
+        iseq = RubyVM::InstructionSequence.load_from_binary(File.binread(cached))
+        @hits += 1
+        iseq
+      rescue SystemCallError, RuntimeError, TypeError
+        # unreadable or built by another Ruby, compile the source instead
+        @misses += 1
+        nil
+      end
+
+      private
+
+      def key(path, source)
+        Digest::SHA256.hexdigest("#{RUBY_VERSION}-#{RUBY_REVISION}-#{RUBY_PLATFORM}\0#{path}\0#{source}")
+      end
+
+      def relative(path, root)
+        path.delete_prefix("#{root}/")
+      end
+
+      # a file can only load lazily when it does nothing but define classes or modules at the top level
+      # anything else, like a require or a method call, has side effects that boot has to run up front
+      def lazy_constants(source)
+        body = RubyVM::AbstractSyntaxTree.parse(source).children[2]
+        return [] if body.nil?
+
+        nodes = body.type == :BLOCK ? body.children : [body]
+        constants = nodes.map do |node|
+          return [] unless %i[CLASS MODULE].include?(node.type) && node.children[0].type == :COLON2
+
+          scope, name = node.children[0].children
+          return [] unless scope.nil?
+
+          name
+        end
+        constants.uniq
+      end
+    end
+
+    module LoadHook
+      def load_iseq(path)
+        CodeCache.load(path)
+      end
+    end
+  end
+end
@@ -1,10 +1,16 @@
 # frozen_string_literal: true
 
+require 'json'
+
 module RBScene
   class Debug
     @rects = []
+    @startup_times = {}
+    @report_startup = false
 
     class << self
+      attr_accessor :report_startup
+
       def add_rect(rect)
         @rects.push(rect)
       end
@@ -12,6 +18,55 @@ module RBScene
       def remove_rect(rect)
         @rects.delete(rect)
       end
+
+      # milliseconds spent in each phase of boot.rb, in the order they ran
+      def startup_times
+        @startup_times.dup
+      end
+
+      def time_startup(phase, started = Process.clock_gettime(Process::CLOCK_MONOTONIC))
+        yield if block_given?
+        @startup_times[phase] = (Process.clock_gettime(Process::CLOCK_MONOTONIC) - started) * 1000.0
+      end
+
+      def startup_report
+        phases = @startup_times.map { |phase, ms| format('%s %.1f', phase, ms) }.join(', ')
+        format('startup %<total>.1f ms (%<phases>s), code cache %<hits>d hits, %<misses>d misses, %<deferred>d classes deferred',
+               total: @startup_times.values.sum, phases: phases, **CodeCache.stats)
+      end
+
+      # hit and miss counts for every class using GameObject.pool
+      def pool_stats
+        GameObject.pooled_classes.to_h { |klass| [klass, klass.pool_stats] }
+      end
+
+      # writes the profiler's recorded frames as Chrome trace events, open with chrome://tracing or Perfetto
+      def export_trace(path)
+        events = []
+        frame_stats.each do |frame|
+          start = frame[:start_ms] * 1000.0
+          events.push(trace_event("frame #{frame[:frame]}", start, frame[:total_ms], 'frame'))
+
+          frame[:phases].each do |phase, ms|
+            next if ms.zero?
+
+            events.push(trace_event(phase.to_s, start, ms, 'phase'))
+            start += ms * 1000.0
+          end
+        end
+
+        # per class update costs aren't kept per frame, they ride along on the latest frame's event
+        classes = class_stats.to_h { |klass, stats| [klass.name || klass.inspect, stats] }
+        events.reverse_each.find { |event| event[:cat] == 'frame' }&.store(:args, classes) unless classes.empty?
+
+        File.write(path, JSON.generate({ traceEvents: events, displayTimeUnit: 'ms' }))
+      end
+
+      private
+
+      def trace_event(name, start_us, duration_ms, category)
+        { name: name, cat: category, ph: 'X', ts: start_us.round(3), dur: (duration_ms * 1000.0).round(3), pid: 1, tid: 1 }
+      end
     end
   end
 end
@@ -0,0 +1,94 @@
+# frozen_string_literal: true
+
+module RBScene
+  # particles simulated and drawn in C, Ruby only configures the emitter and triggers bursts
+  # add one to a scene with Scene#add_emitter, particles are in world space once they spawn
+  class Emitter
+    # more methods defined in C
+
+    attr_reader :texture, :frames, :lifetime, :velocity_x, :velocity_y, :size, :color, :end_color, :width, :height
+
+    # lifetime, velocity_x, velocity_y and size take a Numeric or a Range, each particle picks a value in the range
+    # colors are [r, g, b] or [r, g, b, a] arrays, particles fade out to a transparent color unless end_color is set
+    def initialize(x: 0, y: 0, width: 0, height: 0, rate: 0, lifetime: 1.0, velocity_x: 0, velocity_y: 0,
+                   gravity: [0, 0], size: 4, color: [255, 255, 255, 255], end_color: nil,
+                   texture: nil, frames: nil, max_particles: 10_000, seed: nil)
+      self.max_particles = max_particles
+      self.seed = seed if seed
+      move_to(x, y)
+      resize(width, height)
+      self.rate = rate
+      self.lifetime = lifetime
+      self.velocity_x = velocity_x
+      self.velocity_y = velocity_y
+      self.gravity = gravity
+      self.size = size
+      @end_color = end_color
+      self.color = color
+      set_texture_and_frames(texture, frames)
+    end
+
+    def lifetime=(value)
+      @lifetime = value
+      set_range(:lifetime, *bounds(value))
+    end
+
+    def velocity_x=(value)
+      @velocity_x = value
+      set_range(:velocity_x, *bounds(value))
+    end
+
+    def velocity_y=(value)
+      @velocity_y = value
+      set_range(:velocity_y, *bounds(value))
+    end
+
+    def size=(value)
+      @size = value
+      set_range(:size, *bounds(value))
+    end
+
+    def color=(value)
+      @color = value
+      set_colors(value, @end_color || [*value.first(3), 0])
+    end
+
+    def end_color=(value)
+      @end_color = value
+      self.color = @color
+    end
+
+    # particles spawn anywhere in the width x height area whose top left is the emitter's position
+    def resize(width, height)
+      @width = width
+      @height = height
+      set_area(width, height)
+    end
+
+    # a path or a Texture, nil draws plain squares
+    def texture=(texture)
+      set_texture_and_frames(texture, nil)
+    end
+
+    # a Rect or an array of Rects in the texture, like the ones Texture#split returns
+    def frames=(frames)
+      set_texture_and_frames(@texture, frames)
+    end
+
+    private
+
+    def set_texture_and_frames(texture, frames)
+      texture = Assets.load_texture(texture) if texture.is_a?(String)
+      frames = frames.is_a?(Rect) ? [frames] : Array(frames)
+      raise ArgumentError, 'Emitter frames need a texture' if texture.nil? && !frames.empty?
+
+      set_texture(texture, frames)
+      @texture = texture
+      @frames = frames.freeze
+    end
+
+    def bounds(value)
+      value.is_a?(Range) ? [value.begin, value.end] : [value, value]
+    end
+  end
+end
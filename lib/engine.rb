@@ -3,18 +3,41 @@
 module RBScene
   class Engine
     class Config
-      attr_accessor :window_title, :window_size, :start_scene
+      attr_accessor :window_title, :window_size, :start_scene, :asset_upload_budget,
+                    :headless, :max_frames, :record_frame_times,
+                    :fixed_dt, :max_substeps, :target_fps, :interpolate,
+                    :gc_mode, :gc_on_scene_switch, :gc_max_skipped_frames, :asset_budget
 
       def initialize
         @window_title = 'Untitled'
         @window_size = [800, 600]
         @start_scene = nil # should maybe pick the first scene in the directory?
+        @asset_upload_budget = 4 # milliseconds per frame spent uploading assets loaded in the background
+        @headless = false # run without a window or audio device, frames are not capped to 60 fps
+        @max_frames = nil # stop after this many frames, nil runs until the window closes
+        @record_frame_times = false # keep every frame's duration for Engine.frame_times
+        @fixed_dt = 1.0 / 60 # seconds of game time per update, updates and tickers run at this rate whatever the fps
+        @max_substeps = 5 # most updates run in one frame to catch up after a slow one
+        @target_fps = 60 # frame cap for drawing, 0 for uncapped
+        @interpolate = true # draw positions between the last two updates so motion is smooth at any fps
+        # :ruby leaves GC to Ruby, :frame turns GC off entirely while a frame's updates and drawing run
+        # and collects in the time left before present once about a quarter of the heap has been allocated since the
+        # last collection, so a frame that allocates a lot grows the heap rather than pausing
+        @gc_mode = :ruby
+        @gc_on_scene_switch = true # full collection at the end of a frame that switched scenes
+        @gc_max_skipped_frames = 30 # :frame mode collects anyway after this many frames without time to spare
+        # megabytes of cached assets to keep, past it assets no scene is using are evicted oldest first, nil for no limit
+        @asset_budget = 256
       end
     end
 
     @config = Config.new
+    @scene_switches = 0
+    @pending_switch = nil
 
     class << self
+      attr_reader :config
+
       def configure
         yield @config if block_given?
 
@@ -23,24 +46,72 @@ module RBScene
           raise 'Start scene must be a class that inherits from Scene'
         end
 
-        @current_scene = @config.start_scene.new
+        @current_scene = Assets.enter_scene { @config.start_scene.new }
       end
 
       def scene
         @current_scene
       end
 
-      def switch_scene(next_scene)
-        @current_scene = next_scene.new
+      # the current scene keeps running while next_scene's Scene.preload assets load in the background,
+      # then next_scene is built at the start of the first frame they're all uploaded in
+      # transition is a scene class shown in the meantime, eg. a loading screen reading Engine.switch_progress
+      # the engine collects garbage from the old scene at the end of the frame, see Config#gc_on_scene_switch
+      # assets only the old scene used stay cached until they push the cache past Config#asset_budget
+      def switch_scene(next_scene, transition: nil)
+        scope = Assets.new_scope
+        assets = Assets.within(scope) { Assets.preload(next_scene.preload_paths) }
+
+        # a newer switch replaces one that hasn't happened yet, released after preloading so shared assets stay
+        Assets.release_scope(@pending_switch[:scope]) if @pending_switch
+        @pending_switch = { scene: next_scene, transition: transition, scope: scope, assets: assets }
+        nil
+      end
+
+      def switching?
+        !@pending_switch.nil?
+      end
+
+      # fraction of the pending scene's preloads that are ready, 1.0 when no switch is pending
+      def switch_progress
+        return 1.0 unless @pending_switch
+
+        assets = @pending_switch[:assets]
+        assets.empty? ? 1.0 : assets.count(&:loaded?).fdiv(assets.size)
       end
 
       def window_size
         @config.window_size
       end
 
+      def fixed_dt
+        @config.fixed_dt
+      end
+
       def window_rect
         Rect.new(0, 0, *@config.window_size)
       end
+
+      private
+
+      # called by the engine at the start of each frame while a switch is pending
+      def advance_switch
+        pending = @pending_switch
+        transition = pending.delete(:transition)
+        if transition
+          replace_scene { Assets.enter_scene { transition.new } }
+        elsif pending[:assets].all?(&:loaded?)
+          @pending_switch = nil
+          replace_scene { Assets.enter_scene(pending[:scope]) { pending[:scene].new } }
+        end
+      end
+
+      def replace_scene
+        previous = @current_scene
+        @scene_switches += 1
+        @current_scene = yield
+        previous&.send(:teardown)
+      end
     end
   end
 end
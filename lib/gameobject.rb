@@ -6,50 +6,71 @@ module RBScene
 
     attr_accessor :scene, :props
 
-    def initialize(x: nil, y: nil, width: nil, height: nil, angle: nil, frame: nil, hflip: nil, vflip: nil,
-                   origin_x: nil, origin_y: nil, **kwargs)
+    # bookkeeping for Scene, the object's index in the scene's object array and whether it's a UI object
+    attr_accessor :scene_index, :scene_ui
+    attr_writer :destroyed
+
+    # hitbox relative to the top left of the sprite, registered with the scene's collision world on create
+    attr_reader :hitbox_rect
+
+    def initialize(**kwargs)
       # array of events per key
       @events = Hash.new { |h, k| h[k] = [] }
-      @props = kwargs
 
       @texture = self.class.default_texture
-      if @texture
-        # make_render_props is a private, internal C function that creates a blank render props object
-        @render_props = make_render_props(self.class.default_texture)
-
-        default_x, default_y = self.class.default_position
-        @render_props.x = x || default_x
-        @render_props.y = y || default_y
-
-        default_width, default_height = self.class.default_size(@texture)
-        @render_props.width = width || default_width
-        @render_props.height = height || default_height
-
-        @render_props.angle = angle || self.class.default_angle
-
-        @render_props.frame = frame || self.class.default_frame(@texture)
+      # make_render_props is a private, internal C function that creates a blank render props object
+      @render_props = make_render_props(@texture) if @texture
 
-        @render_props.hflip = hflip || self.class.default_hflip
-        @render_props.vflip = vflip || self.class.default_vflip
-
-        @render_props.origin_x = origin_x || self.class.default_origin_x
-        @render_props.origin_y = origin_y || self.class.default_origin_y
-      end
-
-      # each object's ticker manager should be updated globally
+      # tickers are advanced for every object by the engine, before objects update
       @ticker_manager = TickerManager.new
 
+      assign(**kwargs)
+      setup
+    end
+
+    # brings back an object from its class's pool, it keeps its render slot, ticker manager and events hash
+    # everything the last life left behind is cleared first, then reset runs for state setup doesn't cover
+    def recycle(**kwargs)
+      @events.clear
+      @ticker_manager.clear
+      reset
+      assign(**kwargs)
       setup
     end
 
     # method stub to be overridden
     def setup; end
 
+    # method stub to be overridden, called before setup when a pooled object is reused
+    def reset; end
+
     # method stub to be overridden
+    # objects whose class leaves this empty are skipped by the engine instead of being called every frame
     def update; end
 
+    # inactive objects are still drawn and collide, but update isn't called until they're activated
+    def deactivate
+      @sleeping = true
+    end
+
+    def activate
+      @sleeping = false
+    end
+
+    def active?
+      !@sleeping
+    end
+
+    def active=(value)
+      @sleeping = !value
+    end
+
     def destroy
-      scene.destroy(self)
+      scene&.destroy(self)
+    end
+
+    def destroyed?
+      @destroyed
     end
 
     def move_toward(targetx, targety, speed)
@@ -83,7 +104,10 @@ module RBScene
       raise 'no impl for set_texture'
     end
 
-    def get_position
+    # pass a Vector2 to have it filled in instead of getting a new [x, y] Array
+    def get_position(out = nil)
+      return @render_props.position(out) if out
+
       [@render_props.x, @render_props.y]
     end
 
@@ -92,7 +116,15 @@ module RBScene
       @render_props.y = y
     end
 
-    def get_size
+    # moves without the draw interpolating from the old position, for respawns and warps
+    def teleport(x: 0, y: 0)
+      set_position(x: x, y: y)
+      @render_props.snap
+    end
+
+    def get_size(out = nil)
+      return @render_props.size(out) if out
+
       [@render_props.width, @render_props.height]
     end
 
@@ -113,8 +145,9 @@ module RBScene
       @render_props.frame = rect
     end
 
-    def get_frame
-      @render_props.frame
+    # pass a Rect to copy the frame into instead of allocating a new one
+    def get_frame(out = nil)
+      @render_props.frame(out)
     end
 
     def get_hflip
@@ -142,15 +175,74 @@ module RBScene
       @render_props.origin_y = y
     end
 
+    # objects are drawn by layer, then by z within a layer, so they can be reordered without being recreated
+    def get_layer
+      @render_props.layer
+    end
+
+    def set_layer(layer)
+      @render_props.layer = layer
+    end
+
+    def get_z
+      @render_props.z
+    end
+
+    def set_z(z)
+      @render_props.z = z
+    end
+
+    # static objects are baked with the rest of their layer's static objects and drawn as one texture
+    # changing one is fine but rebakes the whole layer, so it's meant for scenery that rarely changes
+    # the texture goes under every dynamic object on the layer whatever their z, put ones meant to be on top on a higher layer
+    def static?
+      @render_props.static?
+    end
+
+    def set_static(static)
+      @render_props.static = static
+    end
+
+    # world space hitbox, nil if this object has none or isn't in a scene yet
+    def get_hitbox
+      scene&.hitbox(self)
+    end
+
+    def set_hitbox(rect)
+      @hitbox_rect = rect
+      scene&.set_hitbox(self, rect)
+    end
+
     # helpers
 
     def inspect
-      "GameObject(x: #{@render_props.x}, y: #{@render_props.y}, width: #{@render_props.width}, height: #{@render_props.height}, angle: #{@render_props.angle}, frame: #{@render_props.frame}, hflip: #{@render_props.hflip}, vflip: #{@render_props.vflip})"
+      "GameObject(x: #{@render_props.x}, y: #{@render_props.y}, layer: #{@render_props.layer}, z: #{@render_props.z}, width: #{@render_props.width}, height: #{@render_props.height}, angle: #{@render_props.angle}, frame: #{@render_props.frame}, hflip: #{@render_props.hflip}, vflip: #{@render_props.vflip})"
     end
 
     class << self
+      # the engine caches which classes override update, anything that could change that clears the cache
+      def method_added(name)
+        super
+        GameObject.invalidate_update_cache if name == :update
+      end
+
+      def inherited(subclass)
+        super
+        GameObject.invalidate_update_cache
+      end
+
+      def include(*modules)
+        UpdateWatcher.watch(modules)
+        super.tap { GameObject.invalidate_update_cache }
+      end
+
+      def prepend(*modules)
+        UpdateWatcher.watch(modules)
+        super.tap { GameObject.invalidate_update_cache }
+      end
+
       def texture(path)
-        @default_texture = Assets.load_texture(path)
+        @default_texture = Assets.pinned { Assets.load_texture(path) }
       end
 
       def position(x: 0, y: 0)
@@ -169,6 +261,66 @@ module RBScene
         @default_frame = rect
       end
 
+      def layer(layer)
+        @default_layer = layer
+      end
+
+      def z(z)
+        @default_z = z
+      end
+
+      # see GameObject#static?, static objects draw below the dynamic ones on their layer
+      def static(static = true)
+        @default_static = static
+      end
+
+      # width and height default to the object's size
+      def hitbox(x: 0, y: 0, width: nil, height: nil)
+        @default_hitbox = [x, y, width, height]
+      end
+
+      # keeps up to size destroyed objects to hand back out from Scene#create instead of building new ones
+      # reused objects keep their instance variables, override reset to clear what setup doesn't
+      def pool(size:)
+        @pool_size = size
+        @pool = []
+        @pool_hits = 0
+        @pool_misses = 0
+        GameObject.pooled_classes.push(self) unless GameObject.pooled_classes.include?(self)
+      end
+
+      def pooled?
+        !@pool.nil?
+      end
+
+      def pooled_classes
+        @pooled_classes ||= []
+      end
+
+      def acquire(**kwargs)
+        obj = @pool.pop
+        if obj
+          @pool_hits += 1
+          obj.recycle(**kwargs)
+        else
+          @pool_misses += 1
+          obj = new(**kwargs)
+        end
+        obj
+      end
+
+      # a pooled object forgets its scene so the pool doesn't keep a replaced scene alive
+      def release(obj)
+        return unless @pool.size < @pool_size
+
+        obj.scene = nil
+        @pool.push(obj)
+      end
+
+      def pool_stats
+        { size: @pool_size, available: @pool.size, hits: @pool_hits, misses: @pool_misses }
+      end
+
       def origin(x: 0, y: 0)
         # TODO: This is inconsistent with the other setters. Which do you prefer?
         @default_origin_x = x
@@ -189,8 +341,27 @@ module RBScene
         @default_angle || 0
       end
 
+      # the frame setter copies the Rect, so one shared default saves allocating one per object
       def default_frame(texture)
-        @default_frame || Rect.new(0, 0, *default_size(texture))
+        return @default_frame if @default_frame
+
+        width, height = default_size(texture)
+        frame = @default_frame_cache
+        return frame if frame && frame.w == width && frame.h == height
+
+        @default_frame_cache = Rect.new(0, 0, width, height)
+      end
+
+      def default_layer
+        @default_layer || 0
+      end
+
+      def default_z
+        @default_z || 0
+      end
+
+      def default_static
+        @default_static || false
       end
 
       def default_hflip
@@ -208,6 +379,81 @@ module RBScene
       def default_origin_y
         @default_origin_y || 0
       end
+
+      # reuse is filled in instead of allocating, for recycled objects
+      def default_hitbox(object_width, object_height, reuse = nil)
+        return nil unless @default_hitbox
+
+        x, y, width, height = @default_hitbox
+        return reuse.set(x, y, width || object_width, height || object_height) if reuse
+
+        Rect.new(x, y, width || object_width, height || object_height)
+      end
+    end
+
+    # extended onto modules mixed into game objects, so an update added to one later, or to a module
+    # it includes, still clears the cache
+    module UpdateWatcher
+      # modules they already include are watched as well
+      def self.watch(modules)
+        modules.flat_map(&:ancestors).uniq.each { |mod| mod.extend(UpdateWatcher) }
+      end
+
+      def method_added(name)
+        super
+        GameObject.invalidate_update_cache if name == :update
+      end
+
+      def include(*modules)
+        UpdateWatcher.watch(modules)
+        super.tap { GameObject.invalidate_update_cache }
+      end
+
+      def prepend(*modules)
+        UpdateWatcher.watch(modules)
+        super.tap { GameObject.invalidate_update_cache }
+      end
+    end
+
+    private
+
+    # everything initialize and recycle have in common, render props are set in place so a reused slot stays put
+    def assign(x: nil, y: nil, width: nil, height: nil, angle: nil, frame: nil, hflip: nil, vflip: nil,
+               origin_x: nil, origin_y: nil, layer: nil, z: nil, static: nil, **kwargs)
+      @sleeping = false
+      @destroyed = false
+      @props = kwargs
+
+      return unless @render_props
+
+      default_x, default_y = self.class.default_position
+      @render_props.x = x || default_x
+      @render_props.y = y || default_y
+
+      default_width, default_height = self.class.default_size(@texture)
+      @render_props.width = width || default_width
+      @render_props.height = height || default_height
+
+      @render_props.angle = angle || self.class.default_angle
+
+      @render_props.frame = frame || self.class.default_frame(@texture)
+
+      @render_props.hflip = hflip || self.class.default_hflip
+      @render_props.vflip = vflip || self.class.default_vflip
+
+      @render_props.origin_x = origin_x || self.class.default_origin_x
+      @render_props.origin_y = origin_y || self.class.default_origin_y
+
+      @render_props.layer = layer || self.class.default_layer
+      @render_props.z = z || self.class.default_z
+      @render_props.static = static.nil? ? self.class.default_static : static
+
+      # new objects appear where they're created instead of sliding in from 0, 0
+      @render_props.snap
+
+      # only a Rect made here is reused, one passed to set_hitbox still belongs to the caller
+      @default_hitbox_rect = self.class.default_hitbox(@render_props.width, @render_props.height, @default_hitbox_rect)
+      @hitbox_rect = @default_hitbox_rect
     end
   end
 end
@@ -0,0 +1,20 @@
+# frozen_string_literal: true
+
+module RBScene
+  # music streams on a native audio thread, these only queue commands for it so they return right away
+  class Music
+    # more methods defined in C
+
+    # fade crossfades from whatever was playing over that many seconds
+    # playing the music that's already playing keeps it going at the new volume
+    def play(volume: 1.0, fade: 0)
+      start(volume, fade)
+    end
+
+    class << self
+      def stop(fade: 0)
+        fade_out(fade)
+      end
+    end
+  end
+end
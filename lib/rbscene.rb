@@ -5,11 +5,15 @@ require_relative 'vector2'
 require_relative 'rect'
 require_relative 'assets'
 require_relative 'texture'
+require_relative 'music'
+require_relative 'emitter'
+require_relative 'tilemap'
 require_relative 'tickermanager'
 require_relative 'scene'
 require_relative 'gameobject'
 require_relative 'input'
 require_relative 'debug'
+require_relative 'codecache'
 
 # loads the C extension last, extension init function depends on previous classes existing on RBScene
 require 'rbscene/rbscene'
@@ -9,29 +9,44 @@ module RBScene
     def initialize
       @objects = []
       @ui_objects = []
+      # creates and destroys made while the engine is updating are queued and applied after the step
+      # so the arrays C is iterating never change underneath it
+      @spawn_queue = []
+      @despawn_queue = []
+      # native lists of render slots, these are what actually get drawn
+      # world objects are indexed in a spatial grid so only the ones in view get visited
+      @draw_list = DrawList.new(self.class.cull_cell_size)
+      @draw_list.y_sort = self.class.y_sort?
+      @draw_list.static_layers = self.class.static_layers
+      @draw_list.batch_layers = self.class.batch_layers
+      @ui_draw_list = DrawList.new
+      @collision_world = CollisionWorld.new
+      # particle emitters, stepped and drawn by the engine after world objects
+      @emitters = []
+      # tilemaps, drawn underneath everything else in the order they were added
+      @tilemaps = []
       @camera = Camera.new
 
       # stop if empty string is specified
       # continue playing previous music if nil
       path = self.class.music_path
       if path.is_a?(String) && !path.empty?
-        Assets.load_music(path).play
+        Assets.load_music(path).play(fade: self.class.music_fade)
       elsif path == ''
-        RBScene::Music.stop
+        RBScene::Music.stop(fade: self.class.music_fade)
       end
 
       setup
     end
 
+    # objects created during an update join the scene once the current step ends
     def create(type, x: 0, y: 0, ui: false, **kwargs)
-      gobj = type.new(x: x, y: y, **kwargs)
+      gobj = type.pooled? ? type.acquire(x: x, y: y, **kwargs) : type.new(x: x, y: y, **kwargs)
       gobj.scene = self
+      gobj.scene_ui = ui
 
-      if ui
-        @ui_objects.push(gobj)
-      else
-        @objects.push(gobj)
-      end
+      @spawn_queue.push(gobj)
+      apply_pending unless Engine.stepping?
 
       gobj
     end
@@ -45,13 +60,53 @@ module RBScene
       @objects.select { |obj| obj.is_a?(type) }
     end
 
+    def object_count
+      @objects.size + @ui_objects.size
+    end
+
+    # like create, objects destroyed during an update leave the scene once the current step ends
     def destroy(obj)
-      @objects.delete(obj)
-      @ui_objects.delete(obj)
+      return if obj.destroyed? || !obj.scene.equal?(self)
+
+      obj.destroyed = true
+      @despawn_queue.push(obj)
+      apply_pending unless Engine.stepping?
+    end
+
+    def add_emitter(emitter)
+      @emitters.push(emitter) unless @emitters.include?(emitter)
+      emitter
+    end
+
+    def remove_emitter(emitter)
+      @emitters.delete(emitter)
+    end
+
+    def add_tilemap(tilemap)
+      @tilemaps.push(tilemap) unless @tilemaps.include?(tilemap)
+      tilemap
+    end
+
+    def remove_tilemap(tilemap)
+      @tilemaps.delete(tilemap)
+    end
+
+    # pairs of overlapping hitboxes found this frame, each pair is ordered [type_a, type_b]
+    def collisions(type_a = GameObject, type_b = GameObject)
+      @collision_world.pairs(type_a, type_b)
+    end
+
+    # world space hitbox of an object in this scene, nil if it has none
+    def hitbox(obj)
+      @collision_world.hitbox(obj)
     end
 
-    def switch(scene_type)
-      RBScene::Engine.switch_scene(scene_type)
+    def set_hitbox(obj, rect)
+      @collision_world.add(obj, rect)
+    end
+
+    def switch(scene_type, transition: nil)
+      RBScene::Engine.switch_scene(scene_type, transition: transition)
     end
 
     # method stub to be overridden
@@ -63,9 +118,108 @@ module RBScene
     class << self
       attr_reader :music_path
 
-      def music(path)
+      # fade is how many seconds this scene's music takes to crossfade in from the previous scene's
+      def music(path, fade: 0)
         @music_path = path
+        @music_fade = fade
+      end
+
+      def music_fade
+        @music_fade || 0
+      end
+
+      # images and sounds Engine.switch_scene loads in the background before this scene is built
+      # so setup and create find them cached, paths can include globs
+      def preload(*paths)
+        @preload_paths = paths.flatten
+      end
+
+      def preload_paths
+        (@preload_paths || []).flat_map { |path| path.match?(/[*?\[{]/) ? Dir.glob(path).sort : path }
+      end
+
+      # size of the spatial grid cells used for camera culling, in world units
+      # roughly a few times the size of a typical sprite works best
+      def cull_cell_size(size = nil)
+        @cull_cell_size = size if size
+        @cull_cell_size || 256
       end
+
+      # world objects on the same layer and z are drawn by the bottom edge of their sprite, for top down games
+      def y_sort(enabled = true)
+        @y_sort = enabled
+      end
+
+      def y_sort?
+        @y_sort || false
+      end
+
+      # every world object on these layers is drawn from a baked texture, as if each were static
+      # z orders them within the bake as usual, unlike static objects mixed with dynamic ones on a layer
+      # which always draw below them, see GameObject#static?
+      def static_layers(*layers)
+        @static_layers = layers unless layers.empty?
+        @static_layers || []
+      end
+
+      # world objects on these layers with the same z are grouped by texture to save binds
+      # rather than drawn in the order they were added, only for layers where they don't overlap
+      def batch_layers(*layers)
+        @batch_layers = layers unless layers.empty?
+        @batch_layers || []
+      end
+    end
+
+    private
+
+    # called by the engine when another scene replaces this one, so its objects' tickers stop with it
+    def teardown
+      [@objects, @ui_objects, @spawn_queue].each { |objects| objects.each { |obj| obj.ticker.clear } }
+    end
+
+    # called by the engine between steps, destroys go first so an object created and destroyed in one step never appears
+    def apply_pending
+      @despawn_queue.each { |obj| remove_object(obj) }
+      @despawn_queue.clear
+
+      @spawn_queue.each { |obj| obj.destroyed? ? release_object(obj) : add_object(obj) }
+      @spawn_queue.clear
+    end
+
+    def add_object(obj)
+      objects = obj.scene_ui ? @ui_objects : @objects
+      obj.scene_index = objects.size
+      objects.push(obj)
+
+      (obj.scene_ui ? @ui_draw_list : @draw_list).add(obj)
+
+      hitbox = obj.hitbox_rect
+      @collision_world.add(obj, hitbox) if hitbox
+    end
+
+    # the last object is swapped into the gap, update order isn't kept but draw order is, the draw list tracks that
+    def remove_object(obj)
+      index = obj.scene_index
+      return unless index
+
+      objects = obj.scene_ui ? @ui_objects : @objects
+      last = objects.pop
+      unless last.equal?(obj)
+        objects[index] = last
+        last.scene_index = index
+      end
+      obj.scene_index = nil
+
+      (obj.scene_ui ? @ui_draw_list : @draw_list).remove(obj)
+      @collision_world.remove(obj)
+      release_object(obj)
+    end
+
+    # pooled objects go back to their class once they're out of the scene
+    # the engine advances every ticker in its pool, a released object's would keep firing until it's collected
+    def release_object(obj)
+      obj.ticker.clear
+      obj.class.release(obj) if obj.class.pooled?
     end
   end
 end
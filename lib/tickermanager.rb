@@ -2,53 +2,24 @@
 
 module RBScene
   class TickerManager
-    def initialize
-      @tickers = {}
-    end
+    # tickers are stored in a C table owned by the engine and advanced once per update step, before objects update
+    # each ticker gets a reader method, eg. define(:walk) adds ticker.walk
+    # start, running?, value and clear are written in C
 
-    def define(name, rate: 60, limit: 3)
-      @tickers[name] = {
-        running: false,
-        rate: rate,
-        limit: limit,
-        value: 0,
-        counter: 0
-      }
-      define_singleton_method(name) { @tickers[name][:value] }
+    # the block, if given, is called every time the ticker's value wraps back to 0
+    def define(name, rate: 60, limit: 3, &on_complete)
+      add(name, rate, limit, on_complete)
     end
 
     def undefine(name)
-      @tickers.delete(name)
-      undef_method(name)
-    end
-
-    def start(name)
-      @tickers[name][:running] = true
+      remove(name)
     end
 
     def stop(name, reset: false)
-      @tickers[name][:running] = false
-
-      return unless reset
-
-      @tickers[name][:counter] = 0
-      @tickers[name][:value] = 0
+      halt(name, reset)
     end
 
-    def running?(name)
-      @tickers[name][:running]
-    end
-
-    def update(name)
-      t = @tickers[name]
-      return unless t[:running]
-
-      t[:counter] += 1
-      return unless t[:counter] > t[:rate]
-
-      t[:value] += 1
-      t[:value] = 0 if t[:value] >= t[:limit]
-      t[:counter] = 0
-    end
+    # tickers are advanced by the engine now, this is kept so existing update methods still work
+    def update(name); end
   end
 end
@@ -0,0 +1,70 @@
+# frozen_string_literal: true
+
+require 'json'
+
+module RBScene
+  # grid of tiles from one tileset texture, stored and drawn in C
+  # the grid is split into chunks that are rendered once and only redrawn when one of their tiles changes
+  # add one to a scene with Scene#add_tilemap, tilemaps are drawn underneath the scene's objects
+  class Tilemap
+    # more methods defined in C
+
+    # Tiled marks flipped and rotated tiles in the top bits of their ids
+    TILED_FLAG_MASK = 0x1fffffff
+
+    attr_reader :tileset
+
+    class << self
+      # one row of comma separated tile ids per line, -1 is empty like in Tiled's CSV export
+      def load_csv(path, tileset:, tile_width:, tile_height:, **kwargs)
+        tiles = File.readlines(path, chomp: true).reject { |line| line.strip.empty? }.map do |line|
+          line.split(',').map { |id| Integer(id.strip) }
+        end
+
+        new(tiles, tileset: tileset, tile_width: tile_width, tile_height: tile_height, **kwargs)
+      end
+
+      # a tile layer from a map saved by Tiled as JSON, the first tile layer unless one is named
+      # tile ids are relative to the map's first tileset, which should be the texture passed as tileset
+      def load_tiled(path, tileset:, layer: nil, **kwargs)
+        map = JSON.parse(File.read(path))
+        raise ArgumentError, "#{path} is an infinite map, which isn't supported" if map['infinite']
+
+        layers = map['layers'].select { |l| l['type'] == 'tilelayer' }
+        data = layer ? layers.find { |l| l['name'] == layer } : layers.first
+        raise ArgumentError, "#{path} has no tile layer#{" named #{layer}" if layer}" unless data
+        raise ArgumentError, "#{path} layer #{data['name']} isn't CSV encoded" unless data['data'].is_a?(Array)
+
+        first_gid = map.dig('tilesets', 0, 'firstgid') || 1
+        ids = data['data'].map { |gid| gid.zero? ? -1 : (gid & TILED_FLAG_MASK) - first_gid }
+        tiles = ids.each_slice(data['width']).to_a
+
+        new(tiles, tileset: tileset, tile_width: map['tilewidth'], tile_height: map['tileheight'], **kwargs)
+      end
+    end
+
+    # tiles is an array of rows of tile ids, tileset a Texture or a path to one
+    # solid lists the tile ids that solid_at? and solid_in? report
+    def initialize(tiles, tileset:, tile_width:, tile_height:, x: 0, y: 0, solid: [])
+      @tileset = tileset.is_a?(String) ? Assets.load_texture(tileset) : tileset
+      cols = tiles.map(&:size).max || 0
+
+      setup(cols, tiles.size, tile_width, tile_height, @tileset)
+      load_tiles(tiles.flat_map { |row| row + [-1] * (cols - row.size) })
+      self.solid_tiles = solid
+      move_to(x, y)
+    end
+
+    def width
+      cols * tile_width
+    end
+
+    def height
+      rows * tile_height
+    end
+
+    def rect
+      Rect.new(x, y, width, height)
+    end
+  end
+end